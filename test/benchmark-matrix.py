@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# Benchmark for https://github.com/vitaut/zmij/.
+# Copyright (c) 2025 - present, Victor Zverovich
+# Distributed under the MIT license (see LICENSE).
+"""Build dtoa-benchmark for every combination of the zmij configuration
+macros and print a Markdown table with the .text and .rodata sizes of the
+zmij object and the conversion time on each dataset, to choose between
+speed and binary size.
+
+    Usage: python3 test/benchmark-matrix.py [--filter=<regex>]
+                                            [--build-dir=<dir>]
+                                            [--deps-dir=<dir>]
+                                            [--cmake-arg=<arg>...]
+
+--filter selects configurations by name, e.g. --filter=sse4 or
+--filter='^(sse2|no-simd)$'. Builds go to <build-dir>/<config> which
+defaults to a temporary directory. --cmake-arg passes an extra argument such
+as a toolchain file to every configure step. Configurations that fail to
+build are reported in the table rather than aborting the run.
+"""
+
+import itertools
+import json
+import os
+import re
+import shutil
+import sys
+import tempfile
+from pathlib import Path
+
+# abtest.py lives next to this script; reuse its build helpers.
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+from abtest import NOSLEEP, REPO, run  # noqa: E402
+
+MIN_TIME = 0.5  # --benchmark_min_time seconds
+DATASETS = ["", "/canada", "/fixed_range", "/exponential"]
+FILTER = "^zmij(" + "|".join(re.escape(d) for d in DATASETS if d) + ")?$"
+
+# The instruction set options: (name, compiler flags, CMake options).
+ISAS = [
+    ("no-simd", ["-DZMIJ_USE_SIMD=0"], ["-DZMIJ_USE_SIMD=OFF"]),
+    ("sse2", [], []),
+    ("sse4", ["-msse4.1", "-DZMIJ_USE_SSE4_1=1"], []),
+]
+
+# Macros toggled from their defaults: (name, macro, value).
+TOGGLES = [
+    ("no-int128", "ZMIJ_USE_INT128", 0),
+    ("optimize-size", "ZMIJ_OPTIMIZE_SIZE", 1),
+    ("exp-string-table", "ZMIJ_USE_EXP_STRING_TABLE", None),
+    ("no-builtins", "ZMIJ_NO_BUILTINS", 1),
+]
+
+
+def configs():
+    """Yields (name, compiler flags, CMake options) for each combination."""
+    for isa, isa_flags, isa_options in ISAS:
+        for enabled in itertools.product([False, True], repeat=len(TOGGLES)):
+            names, flags = [isa], list(isa_flags)
+            optimize_size = False
+            for on, (name, macro, value) in zip(enabled, TOGGLES):
+                if not on:
+                    continue
+                if value is None:
+                    # The table is enabled by default unless optimizing for
+                    # size so toggling it means the opposite.
+                    value = 1 if optimize_size else 0
+                    name = ("" if value else "no-") + name
+                optimize_size |= macro == "ZMIJ_OPTIMIZE_SIZE"
+                names.append(name)
+                flags.append(f"-D{macro}={value}")
+            yield "+".join(names), flags, isa_options
+
+
+def section_sizes(obj):
+    """Returns the total sizes of the .text* and .rodata* sections of obj."""
+    size = shutil.which("size")
+    if size is None:
+        return None, None
+    text = rodata = 0
+    for line in run([size, "-A", obj]).splitlines():
+        fields = line.split()
+        if len(fields) < 2 or not fields[1].isdigit():
+            continue
+        if fields[0].startswith(".text"):
+            text += int(fields[1])
+        elif fields[0].startswith(".rodata"):
+            rodata += int(fields[1])
+    return text, rodata
+
+
+def build(name, flags, options, build_dir, deps, cmake_args):
+    args = ["cmake", "-S", REPO, "-B", build_dir,
+            "-DCMAKE_BUILD_TYPE=Release",
+            f"-DCMAKE_CXX_FLAGS={' '.join(flags)}",
+            f"-DFETCHCONTENT_BASE_DIR={deps}", *options, *cmake_args]
+    if (deps / "googlebenchmark-src" / "CMakeLists.txt").exists():
+        args.append("-DFETCHCONTENT_FULLY_DISCONNECTED=TRUE")
+    print(f"[build:{name}]", file=sys.stderr)
+    run(args)
+    run(["cmake", "--build", build_dir, "-j", str(os.cpu_count() or 1),
+         "--target", "dtoa-benchmark"])
+    obj = next(build_dir.glob("CMakeFiles/zmij.dir/zmij.cc.o*"))
+    return build_dir / "test" / "dtoa-benchmark", obj
+
+
+def bench(exe, json_path):
+    """Returns the time per double in ns for each dataset."""
+    run([*NOSLEEP, exe, f"--benchmark_min_time={MIN_TIME}s",
+         f"--benchmark_filter={FILTER}", f"--json-out={json_path}"])
+    times = {}
+    for b in json.loads(json_path.read_text()).get("benchmarks", []):
+        times[b["name"]] = float(b["Time/double"]) * 1e9
+    return [times.get("zmij" + d) for d in DATASETS]
+
+
+def cell(value, fmt):
+    return "n/a" if value is None else fmt.format(value)
+
+
+def main():
+    config_filter = None
+    build_root = None
+    cmake_args = []
+    deps = Path.home() / ".cache" / "zmij_bench_deps"
+    for arg in sys.argv[1:]:
+        if arg in ("-h", "--help"):
+            sys.exit(__doc__)
+        elif arg.startswith("--filter="):
+            config_filter = re.compile(arg[len("--filter="):])
+        elif arg.startswith("--build-dir="):
+            build_root = Path(arg[len("--build-dir="):])
+        elif arg.startswith("--deps-dir="):
+            deps = Path(arg[len("--deps-dir="):])
+        elif arg.startswith("--cmake-arg="):
+            cmake_args.append(arg[len("--cmake-arg="):])
+        else:
+            sys.exit(__doc__)
+    deps.mkdir(parents=True, exist_ok=True)
+
+    header = ["config", ".text", ".rodata",
+              *("mixed" if not d else d[1:] for d in DATASETS)]
+    rows = []
+    with tempfile.TemporaryDirectory(prefix="zmij_matrix_") as tmpdir:
+        root = build_root or Path(tmpdir)
+        for name, flags, options in configs():
+            if config_filter and not config_filter.search(name):
+                continue
+            try:
+                exe, obj = build(name, flags, options, root / name, deps,
+                                 cmake_args)
+                text, rodata = section_sizes(obj)
+                times = bench(exe, root / f"{name}.json")
+            except (SystemExit, StopIteration) as e:
+                message = str(e).splitlines()
+                print(f"  {name} failed: {message[0] if message else ''}",
+                      file=sys.stderr)
+                rows.append([name, "failed", "", *([""] * len(DATASETS))])
+                continue
+            rows.append([name, cell(text, "{}"), cell(rodata, "{}"),
+                         *(cell(t, "{:.2f}ns") for t in times)])
+
+    widths = [max(len(r[i]) for r in [header, *rows])
+              for i in range(len(header))]
+
+    def line(r):
+        return "| " + " | ".join(c.ljust(w) for c, w in zip(r, widths)) + " |"
+
+    print(line(header))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for r in rows:
+        print(line(r))
+
+
+if __name__ == "__main__":
+    main()
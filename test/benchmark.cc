@@ -12,11 +12,13 @@
 #include <algorithm>  // std::sort, std::shuffle
 #include <cmath>      // std::abs, std::isnan, std::isinf
 #include <fstream>
+#include <iterator>  // std::begin, std::end
 #include <limits>
 #include <random>  // std::mt19937
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>  // std::pair
 
 #include "fmt/format.h"
 
@@ -88,6 +90,33 @@ auto get_mixed_pool() -> const std::vector<T>& {
   return pool;
 }
 
+// Sets counters for `count` conversions per iteration.
+template <typename T>
+static void set_counters(benchmark::State& state, size_t count) {
+  state.counters["Throughput"] = benchmark::Counter(
+      static_cast<double>(count),
+      benchmark::Counter::kIsIterationInvariantRate);
+  const char* time_label =
+      std::is_same_v<T, double> ? "Time/double" : "Time/float";
+  state.counters[time_label] = benchmark::Counter(
+      static_cast<double>(count),
+      benchmark::Counter::kIsIterationInvariantRate |
+          benchmark::Counter::kInvert);
+}
+
+// Returns x with a false data dependency on zero which must be 0 but isn't
+// known to be 0 by the compiler, so the next conversion can't start before
+// the previous one finishes.
+template <typename T> static auto depend_on(T x, uint64_t zero) -> T {
+  using uint = std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t,
+                                  uint64_t>;
+  uint bits = 0;
+  memcpy(&bits, &x, sizeof(x));
+  bits ^= uint(zero);
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
 template <typename T>
 static void run_to_chars(benchmark::State& state,
                          auto (*to_chars)(T, char*)->char*, int digit) {
@@ -134,6 +163,69 @@ static void run_to_chars_mixed(benchmark::State& state,
           benchmark::Counter::kInvert);
 }
 
+template <typename T>
+static void run_to_decimal_precision(benchmark::State& state,
+                                     auto (*to_decimal)(T, int)->decimal,
+                                     int precision) {
+  const auto& pool = get_mixed_pool<T>();
+  for (auto _ : state) {
+    for (T x : pool) {
+      decimal dec = to_decimal(x, precision);
+      benchmark::DoNotOptimize(dec);
+    }
+  }
+  set_counters<T>(state, pool.size());
+}
+
+// Measures throughput: conversions are independent so the CPU can overlap
+// them.
+template <typename T>
+static void run_to_decimal(benchmark::State& state,
+                           auto (*to_decimal)(T)->decimal) {
+  const auto& pool = get_mixed_pool<T>();
+  for (auto _ : state) {
+    for (T x : pool) {
+      decimal dec = to_decimal(x);
+      benchmark::DoNotOptimize(dec);
+    }
+  }
+  set_counters<T>(state, pool.size());
+}
+
+// Measures latency: each input depends on the previous result so the
+// conversions form a dependent chain and can't overlap.
+template <typename T>
+static void run_to_decimal_latency(benchmark::State& state,
+                                   auto (*to_decimal)(T)->decimal) {
+  const auto& pool = get_mixed_pool<T>();
+  for (auto _ : state) {
+    decimal dec = {};
+    for (T x : pool) dec = to_decimal(depend_on(x, uint64_t(dec.sig) >> 63));
+    benchmark::DoNotOptimize(dec);
+  }
+  set_counters<T>(state, pool.size());
+}
+
+template <typename T>
+static void run_to_decimal_batch(benchmark::State& state,
+                                 void (*to_decimal_batch)(const T*, size_t,
+                                                          decimal*)) {
+  const auto& pool = get_mixed_pool<T>();
+  // Convert in chunks that fit in L1 to measure conversion rather than
+  // memory bandwidth.
+  constexpr size_t chunk_size = 256;
+  decimal results[chunk_size];
+  for (auto _ : state) {
+    for (size_t i = 0; i < pool.size(); i += chunk_size) {
+      size_t n = std::min(chunk_size, pool.size() - i);
+      to_decimal_batch(pool.data() + i, n, results);
+      benchmark::DoNotOptimize(results);
+      benchmark::ClobberMemory();
+    }
+  }
+  set_counters<T>(state, pool.size());
+}
+
 // Doubles extracted from the canonical canada.json corpus (GeoJSON polygon of
 // Canada). canada.h is a bare initializer list, one number per line.
 static const double canada_numbers[] = {
@@ -161,6 +253,12 @@ static void run_to_chars_canada(benchmark::State& state,
           benchmark::Counter::kInvert);
 }
 
+static const std::vector<double>& get_canada_numbers() {
+  static const std::vector<double> v(std::begin(canada_numbers),
+                                     std::end(canada_numbers));
+  return v;
+}
+
 // Doubles drawn uniformly from zmij's fixed-notation decimal-exponent range,
 // dec_exp in [-4, 15]: each decade is equally weighted, so the negative-
 // exponent side (which canada.json doesn't cover) gets ~20% of samples. Signs
@@ -188,9 +286,75 @@ static const std::vector<double>& get_fixed_range_numbers() {
   return v;
 }
 
-static void run_to_chars_fixed_range(
-    benchmark::State& state, auto (*to_chars)(double, char*)->char*) {
-  const auto& nums = get_fixed_range_numbers();
+// Doubles in exponential notation: the decimal exponent is drawn uniformly
+// from [-300, -5] and [16, 300], outside of the fixed-notation range, with
+// random significands of up to 17 digits as in scientific data.
+static const std::vector<double>& get_exponential_numbers() {
+  static const std::vector<double> v = [] {
+    constexpr size_t count =
+        sizeof(canada_numbers) / sizeof(canada_numbers[0]);
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<int> exp_dist(-300, 280);
+    std::uniform_real_distribution<double> sig_dist(1.0, 10.0);
+    std::bernoulli_distribution sign_dist(0.5);
+    std::vector<double> out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      double sig = sig_dist(rng);
+      int e = exp_dist(rng);
+      if (e > -5) e += 20;  // Skip [-4, 15].
+      double val = sig * std::pow(10.0, e);
+      if (sign_dist(rng)) val = -val;
+      out.push_back(val);
+    }
+    return out;
+  }();
+  return v;
+}
+
+// Doubles with random bits constructed by bits_for, which is passed a random
+// 64-bit number. Sized to roughly match canada_numbers.
+static auto make_numbers(uint64_t (*bits_for)(uint64_t))
+    -> std::vector<double> {
+  constexpr size_t count = sizeof(canada_numbers) / sizeof(canada_numbers[0]);
+  std::mt19937_64 rng(0);
+  std::vector<double> out;
+  out.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t bits = bits_for(rng());
+    double val = 0;
+    memcpy(&val, &bits, sizeof(val));
+    out.push_back(val);
+  }
+  return out;
+}
+
+// Subnormal doubles with random signs and significands of random bit
+// lengths, so they have from 1 to 17 significant digits, as produced by
+// underflowing simulations.
+static const std::vector<double>& get_subnormal_numbers() {
+  static const std::vector<double> v = make_numbers([](uint64_t r) {
+    constexpr uint64_t sig_mask = (uint64_t(1) << 52) - 1;
+    uint64_t sig = (r & sig_mask) >> (r >> 52) % 52;
+    return (r & (uint64_t(1) << 63)) | (sig != 0 ? sig : 1);
+  });
+  return v;
+}
+
+// Powers of 2 with random signs and exponents: the binary significand is
+// zero and the rounding interval is asymmetric, taking the irregular path.
+static const std::vector<double>& get_irregular_numbers() {
+  static const std::vector<double> v = make_numbers([](uint64_t r) {
+    uint64_t exp = (r >> 52) % 2046 + 1;
+    return (r & (uint64_t(1) << 63)) | exp << 52;
+  });
+  return v;
+}
+
+static void run_to_chars_numbers(benchmark::State& state,
+                                 auto (*to_chars)(double, char*)->char*,
+                                 const std::vector<double>& (*get_numbers)()) {
+  const auto& nums = get_numbers();
   char buffer[256];
   for (auto _ : state) {
     for (double x : nums) {
@@ -208,6 +372,27 @@ static void run_to_chars_fixed_range(
           benchmark::Counter::kInvert);
 }
 
+// Measures latency: the bits of each value are combined with the length of
+// the previous output so that the conversions form a dependent chain and
+// can't overlap, as when formatting one number at a time.
+template <typename T>
+static void run_to_chars_latency(benchmark::State& state,
+                                 auto (*to_chars)(T, char*)->char*,
+                                 const std::vector<T>& (*get_numbers)()) {
+  const auto& nums = get_numbers();
+  char buffer[256];
+  for (auto _ : state) {
+    char* end = buffer;
+    for (T x : nums) {
+      // The length is below 256 so the shifted length is 0.
+      end = to_chars(depend_on(x, uint64_t(end - buffer) >> 8), buffer);
+      benchmark::ClobberMemory();
+    }
+    benchmark::DoNotOptimize(end);
+  }
+  set_counters<T>(state, nums.size());
+}
+
 // Formats a counter value with 2 fractional digits, applying SI auto-scaling
 // so the mantissa always sits in [1, 1000) (or in [0.01, 1) for tiny values).
 static auto format_counter(double n) -> std::string {
@@ -261,7 +446,7 @@ class pretty_reporter : public benchmark::ConsoleReporter {
 };
 
 template <typename T>
-static void register_all(bool per_digit) {
+static void register_all(bool per_digit, bool latency) {
   auto& v = methods<T>;
   std::sort(v.begin(), v.end(), [](const method<T>& a, const method<T>& b) {
     return a.name < b.name;
@@ -277,25 +462,118 @@ static void register_all(bool per_digit) {
     }
     benchmark::RegisterBenchmark(m.name.c_str(), run_to_chars_mixed<T>,
                                  m.to_chars);
+    if (latency) {
+      auto name = m.name + "/latency";
+      benchmark::RegisterBenchmark(name.c_str(), run_to_chars_latency<T>,
+                                   m.to_chars, get_mixed_pool<T>);
+    }
     if constexpr (std::is_same_v<T, double>) {
       auto canada_name = m.name + "/canada";
       benchmark::RegisterBenchmark(canada_name.c_str(), run_to_chars_canada,
                                    m.to_chars);
       auto fr_name = m.name + "/fixed_range";
-      benchmark::RegisterBenchmark(fr_name.c_str(), run_to_chars_fixed_range,
-                                   m.to_chars);
+      benchmark::RegisterBenchmark(fr_name.c_str(), run_to_chars_numbers,
+                                   m.to_chars, get_fixed_range_numbers);
+      auto exp_name = m.name + "/exponential";
+      benchmark::RegisterBenchmark(exp_name.c_str(), run_to_chars_numbers,
+                                   m.to_chars, get_exponential_numbers);
+      auto subnormal_name = m.name + "/subnormal";
+      benchmark::RegisterBenchmark(subnormal_name.c_str(), run_to_chars_numbers,
+                                   m.to_chars, get_subnormal_numbers);
+      auto irregular_name = m.name + "/irregular";
+      benchmark::RegisterBenchmark(irregular_name.c_str(), run_to_chars_numbers,
+                                   m.to_chars, get_irregular_numbers);
+      if (latency) {
+        std::pair<const char*, const std::vector<double>& (*)()> datasets[] =
+            {{"canada", get_canada_numbers},
+             {"fixed_range", get_fixed_range_numbers},
+             {"exponential", get_exponential_numbers},
+             {"subnormal", get_subnormal_numbers},
+             {"irregular", get_irregular_numbers}};
+        for (const auto& [dataset, get_numbers] : datasets) {
+          auto name = m.name + "/" + dataset + "_latency";
+          benchmark::RegisterBenchmark(name.c_str(),
+                                       run_to_chars_latency<double>,
+                                       m.to_chars, get_numbers);
+        }
+      }
+    }
+  }
+  auto& pv = precision_methods<T>;
+  std::sort(pv.begin(), pv.end(),
+            [](const precision_method<T>& a, const precision_method<T>& b) {
+              return a.name < b.name;
+            });
+  for (const auto& m : pv) {
+    for (int p = 1; p <= max_digits; ++p) {
+      auto name = m.name + "/p" + std::to_string(p);
+      benchmark::RegisterBenchmark(name.c_str(), run_to_decimal_precision<T>,
+                                   m.to_decimal, p);
+    }
+  }
+  auto& dv = decimal_methods<T>;
+  std::sort(dv.begin(), dv.end(),
+            [](const decimal_method<T>& a, const decimal_method<T>& b) {
+              return a.name < b.name;
+            });
+  for (const auto& m : dv) {
+    auto name = m.name + "/to_decimal";
+    benchmark::RegisterBenchmark(name.c_str(), run_to_decimal<T>,
+                                 m.to_decimal);
+    auto latency_name = m.name + "/to_decimal_latency";
+    benchmark::RegisterBenchmark(latency_name.c_str(),
+                                 run_to_decimal_latency<T>, m.to_decimal);
+    if (!m.to_decimal_batch) continue;
+    auto batch_name = m.name + "/to_decimal_batch";
+    benchmark::RegisterBenchmark(batch_name.c_str(), run_to_decimal_batch<T>,
+                                 m.to_decimal_batch);
+  }
+}
+
+static void register_stages(bool per_digit) {
+  std::sort(stages.begin(), stages.end(),
+            [](const stage& a, const stage& b) { return a.name < b.name; });
+  auto reg = [](const std::string& name, const stage& s, auto get_numbers) {
+    benchmark::RegisterBenchmark(
+        name.c_str(), [=](benchmark::State& state) {
+          auto [values, count] = get_numbers();
+          set_counters<double>(state, s.run(state, values, count));
+        });
+  };
+  auto vector_data = [](const std::vector<double>& (*get_numbers)()) {
+    return [=] {
+      const auto& v = get_numbers();
+      return std::pair(v.data(), v.size());
+    };
+  };
+  for (const auto& s : stages) {
+    reg(s.name, s, vector_data(get_mixed_pool<double>));
+    reg(s.name + "/canada", s, vector_data(get_canada_numbers));
+    reg(s.name + "/fixed_range", s, vector_data(get_fixed_range_numbers));
+    reg(s.name + "/exponential", s, vector_data(get_exponential_numbers));
+    reg(s.name + "/subnormal", s, vector_data(get_subnormal_numbers));
+    reg(s.name + "/irregular", s, vector_data(get_irregular_numbers));
+    if (!per_digit) continue;
+    for (int d = 1; d <= std::numeric_limits<double>::max_digits10; ++d) {
+      reg(s.name + "/d" + std::to_string(d), s, [=] {
+        return std::pair(get_random_digit_data<double>(d),
+                         size_t(num_per_digit));
+      });
     }
   }
 }
 
 auto main(int argc, char** argv) -> int {
   bool per_digit = false;
+  bool latency = false;
   std::string json_out;
   int out = 1;
   for (int i = 1; i < argc; ++i) {
     auto arg = std::string_view(argv[i]);
     if (arg == "--per-digit") {
       per_digit = true;
+    } else if (arg == "--latency") {
+      latency = true;
     } else if (arg.substr(0, 11) == "--json-out=") {
       json_out = std::string(arg.substr(11));
     } else {
@@ -304,8 +582,9 @@ auto main(int argc, char** argv) -> int {
   }
   argc = out;
 
-  register_all<double>(per_digit);
-  register_all<float>(per_digit);
+  register_all<double>(per_digit, latency);
+  register_all<float>(per_digit, latency);
+  register_stages(per_digit);
 
   benchmark::Initialize(&argc, argv);
   if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
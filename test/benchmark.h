@@ -5,6 +5,10 @@
 #ifndef BENCHMARK_H_
 #define BENCHMARK_H_
 
+#include <stddef.h>  // size_t
+#include <stdio.h>   // snprintf
+#include <stdlib.h>  // atoi
+
 #include <string>
 #include <vector>
 
@@ -24,10 +28,111 @@ inline auto register_method_(const std::string& name,
   return 0;
 }
 
+// A decimal number sig * 10**exp.
+struct decimal {
+  long long sig;
+  int exp;
+};
+
+// A method that rounds a value to `precision` significant decimal digits.
+template <typename T>
+struct precision_method {
+  std::string name;
+  auto (*to_decimal)(T, int precision) -> decimal;
+};
+
+template <typename T>
+inline std::vector<precision_method<T>> precision_methods;
+
+// Rounds `value` to `precision` significant digits with snprintf's %.*e.
+// Non-finite values give {0, 0}.
+inline auto snprintf_to_decimal(double value, int precision) -> decimal {
+  char buffer[32];
+  int size = snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+  if (size < 0 || size >= int(sizeof(buffer))) return {0, 0};
+  const char* end = buffer + size;
+  long long sig = 0;
+  const char* p = buffer + (buffer[0] == '-');
+  for (; p != end && *p != 'e'; ++p) {
+    if (*p >= '0' && *p <= '9') sig = sig * 10 + (*p - '0');
+  }
+  if (p == end) return {0, 0};  // "inf" or "nan" has no exponent.
+  return {sig, atoi(p + 1) - (precision - 1)};
+}
+
+template <typename T>
+inline auto register_precision_method_(const std::string& name,
+                                       auto (*fn)(T, int) -> decimal) -> int {
+  precision_methods<T>.push_back({name, fn});
+  return 0;
+}
+
+// A method that converts a value to the shortest decimal without formatting.
+template <typename T>
+struct decimal_method {
+  std::string name;
+  auto (*to_decimal)(T) -> decimal;
+  // Converts `count` values at once or is null if there is no batch API.
+  void (*to_decimal_batch)(const T* values, size_t count, decimal* results);
+};
+
+template <typename T>
+inline std::vector<decimal_method<T>> decimal_methods;
+
+template <typename T>
+inline auto register_decimal_method_(
+    const std::string& name, auto (*fn)(T)->decimal,
+    void (*batch_fn)(const T*, size_t, decimal*) = nullptr) -> int {
+  decimal_methods<T>.push_back({name, fn, batch_fn});
+  return 0;
+}
+
+namespace benchmark {
+class State;
+}
+
+// A stage of the conversion such as digit generation benchmarked in
+// isolation. `run` precomputes the stage inputs from `count` values before
+// the timed loop and returns the number of inputs converted per iteration.
+struct stage {
+  std::string name;
+  auto (*run)(benchmark::State& state, const double* values, size_t count)
+      -> size_t;
+};
+
+inline std::vector<stage> stages;
+
+inline auto register_stage_(
+    const std::string& name,
+    auto (*fn)(benchmark::State&, const double*, size_t) -> size_t) -> int {
+  stages.push_back({name, fn});
+  return 0;
+}
+
 #define REGISTER_DTOA(f) \
   static int register_dtoa_##f = register_method_<double>(#f, dtoa_##f)
 
 #define REGISTER_FTOA(f) \
   static int register_ftoa_##f = register_method_<float>(#f, ftoa_##f)
 
+#define REGISTER_DTOA_PRECISION(f)       \
+  static int register_dtoa_precision_##f = \
+      register_precision_method_<double>(#f, dtoa_precision_##f)
+
+#define REGISTER_FTOA_PRECISION(f)       \
+  static int register_ftoa_precision_##f = \
+      register_precision_method_<float>(#f, ftoa_precision_##f)
+
+#define REGISTER_DTOA_DECIMAL(f)       \
+  static int register_dtoa_decimal_##f = \
+      register_decimal_method_<double>(#f, dtoa_decimal_##f)
+
+#define REGISTER_DTOA_DECIMAL_BATCH(f)                     \
+  static int register_dtoa_decimal_##f =                     \
+      register_decimal_method_<double>(#f, dtoa_decimal_##f, \
+                                       dtoa_decimal_batch_##f)
+
+#define REGISTER_STAGE(f) \
+  static int register_stage_##f = register_stage_(#f, stage_##f)
+
 #endif  // BENCHMARK_H_
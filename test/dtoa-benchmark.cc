@@ -2,14 +2,21 @@
 // Copyright (c) 2025 - present, Victor Zverovich
 // Distributed under the MIT license (see LICENSE).
 
+#include <stdio.h>  // snprintf
+
+#include <charconv>  // std::to_chars
+#include <cmath>     // std::isfinite
+
 #include "benchmark.h"
 #include "dragonbox/dragonbox_to_chars.h"
+#include "fmt/format.h"
 #include "zmij.h"
 
 namespace zmij {
 int dtoa(...);
 int to_string(...);
 int write(...);
+int write_hex(...);
 }  // namespace zmij
 
 auto dtoa_zmij(double value, char* buffer) -> char* {
@@ -36,3 +43,83 @@ auto dtoa_dragonbox(double value, char* buffer) -> char* {
 }
 
 REGISTER_DTOA(dragonbox);
+
+// Only if the standard library implements std::to_chars for floating point.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+auto dtoa_to_chars(double value, char* buffer) -> char* {
+  return std::to_chars(buffer, buffer + 32, value).ptr;
+}
+
+REGISTER_DTOA(to_chars);
+#endif
+
+auto dtoa_snprintf(double value, char* buffer) -> char* {
+  return buffer + snprintf(buffer, 32, "%.17g", value);
+}
+
+REGISTER_DTOA(snprintf);
+
+auto dtoa_fmt(double value, char* buffer) -> char* {
+  return fmt::format_to(buffer, "{}", value);
+}
+
+REGISTER_DTOA(fmt);
+
+auto dtoa_zmij_hex(double value, char* buffer) -> char* {
+  using result = decltype(zmij::write_hex(buffer, 24, value));
+  if constexpr (std::is_same_v<result, char*>)
+    return reinterpret_cast<char*>(zmij::write_hex(buffer, 24, value));
+  return nullptr;
+}
+
+REGISTER_DTOA(zmij_hex);
+
+auto dtoa_snprintf_hex(double value, char* buffer) -> char* {
+  return buffer + snprintf(buffer, 32, "%a", value);
+}
+
+REGISTER_DTOA(snprintf_hex);
+
+auto dtoa_decimal_zmij(double value) -> decimal {
+  zmij::dec_fp dec = zmij::to_decimal(value);
+  return {dec.sig, dec.exp};
+}
+
+void dtoa_decimal_batch_zmij(const double* values, size_t count,
+                             decimal* results) {
+  constexpr size_t chunk_size = 64;
+  zmij::dec_fp decs[chunk_size];
+  for (size_t i = 0; i < count; i += chunk_size) {
+    size_t n = count - i < chunk_size ? count - i : chunk_size;
+    zmij::to_decimal(values + i, n, decs);
+    for (size_t j = 0; j < n; ++j) results[i + j] = {decs[j].sig, decs[j].exp};
+  }
+}
+
+REGISTER_DTOA_DECIMAL_BATCH(zmij);
+
+auto dtoa_decimal_dragonbox(double value) -> decimal {
+  // dragonbox requires a finite nonzero input.
+  if (value == 0 || !std::isfinite(value)) return {0, 0};
+  // Keep trailing zeros like zmij::to_decimal.
+  auto dec = jkj::dragonbox::to_decimal(
+      value, jkj::dragonbox::policy::sign::ignore,
+      jkj::dragonbox::policy::trailing_zero::ignore,
+      jkj::dragonbox::policy::cache::full);
+  return {static_cast<long long>(dec.significand), dec.exponent};
+}
+
+REGISTER_DTOA_DECIMAL(dragonbox);
+
+auto dtoa_precision_zmij(double value, int precision) -> decimal {
+  zmij::dec_fp dec = zmij::to_decimal(value, precision);
+  return {dec.sig, dec.exp};
+}
+
+REGISTER_DTOA_PRECISION(zmij);
+
+auto dtoa_precision_snprintf(double value, int precision) -> decimal {
+  return snprintf_to_decimal(value, precision);
+}
+
+REGISTER_DTOA_PRECISION(snprintf);
@@ -0,0 +1,15 @@
+// Benchmark for https://github.com/vitaut/zmij/.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE).
+
+// Includes the C implementation like zmij-test does to compare
+// zmij_write_double with zmij::write in dtoa_zmij in the same harness.
+#define _Alignas(x) alignas(x)
+#include "../zmij.c"
+#include "benchmark.h"
+
+auto dtoa_zmij_c(double value, char* buffer) -> char* {
+  return zmij_write_double(buffer, zmij_double_buffer_size, value);
+}
+
+REGISTER_DTOA(zmij_c);
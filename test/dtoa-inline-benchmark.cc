@@ -0,0 +1,33 @@
+// Benchmark for https://github.com/vitaut/zmij/.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE).
+
+// Compiled with ZMIJ_HEADER_ONLY=1 so that detail::write is visible here and
+// can be inlined. zmij_outline keeps it behind a call like the library does
+// to compare the call cost in the same binary.
+#include "benchmark.h"
+#include "zmij.h"
+
+#ifdef __GNUC__
+[[gnu::flatten]]
+#endif
+auto dtoa_zmij_inline(double value, char* buffer) -> char* {
+  return zmij::write(buffer, zmij::double_buffer_size, value);
+}
+
+REGISTER_DTOA(zmij_inline);
+
+#ifdef __GNUC__
+[[gnu::noinline]]
+#elif defined(_MSC_VER)
+__declspec(noinline)
+#endif
+static auto write_outline(double value, char* buffer) -> char* {
+  return zmij::detail::write(value, buffer);
+}
+
+auto dtoa_zmij_outline(double value, char* buffer) -> char* {
+  return write_outline(value, buffer);
+}
+
+REGISTER_DTOA(zmij_outline);
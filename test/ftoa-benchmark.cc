@@ -2,8 +2,13 @@
 // Copyright (c) 2025 - present, Victor Zverovich
 // Distributed under the MIT license (see LICENSE).
 
+#include <stdio.h>  // snprintf
+
+#include <charconv>  // std::to_chars
+
 #include "benchmark.h"
 #include "dragonbox/dragonbox_to_chars.h"
+#include "fmt/format.h"
 #include "zmij.h"
 
 auto ftoa_zmij(float value, char* buffer) -> char* {
@@ -29,3 +34,37 @@ auto ftoa_dragonbox(float value, char* buffer) -> char* {
 }
 
 REGISTER_FTOA(dragonbox);
+
+// Only if the standard library implements std::to_chars for floating point.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+auto ftoa_to_chars(float value, char* buffer) -> char* {
+  return std::to_chars(buffer, buffer + 32, value).ptr;
+}
+
+REGISTER_FTOA(to_chars);
+#endif
+
+auto ftoa_snprintf(float value, char* buffer) -> char* {
+  return buffer + snprintf(buffer, 32, "%.9g", value);
+}
+
+REGISTER_FTOA(snprintf);
+
+auto ftoa_fmt(float value, char* buffer) -> char* {
+  return fmt::format_to(buffer, "{}", value);
+}
+
+REGISTER_FTOA(fmt);
+
+auto ftoa_precision_zmij(float value, int precision) -> decimal {
+  zmij::dec_fp dec = zmij::to_decimal(value, precision);
+  return {dec.sig, dec.exp};
+}
+
+REGISTER_FTOA_PRECISION(zmij);
+
+auto ftoa_precision_snprintf(float value, int precision) -> decimal {
+  return snprintf_to_decimal(value, precision);
+}
+
+REGISTER_FTOA_PRECISION(snprintf);
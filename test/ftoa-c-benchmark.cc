@@ -0,0 +1,15 @@
+// Benchmark for https://github.com/vitaut/zmij/.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE).
+
+// Includes the C implementation like zmij-test does to compare
+// zmij_write_float with zmij::write in ftoa_zmij in the same harness.
+#define _Alignas(x) alignas(x)
+#include "../zmij.c"
+#include "benchmark.h"
+
+auto ftoa_zmij_c(float value, char* buffer) -> char* {
+  return zmij_write_float(buffer, zmij_float_buffer_size, value);
+}
+
+REGISTER_FTOA(zmij_c);
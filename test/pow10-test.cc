@@ -667,7 +667,7 @@ const uint128 expected[] = {
 TEST(pow10_test, verify) {
   constexpr int dec_exp_min = -307;
   for (int i = 0; i < int(sizeof(expected) / sizeof(*expected)); ++i) {
-    auto actual = static_data.pow10_significands[dec_exp_min + i];
+    auto actual = static_data::value.pow10_significands[dec_exp_min + i];
     EXPECT_EQ(actual.hi, expected[i].hi);
     auto diff = int64_t(actual.lo - expected[i].lo);
     EXPECT_GE(diff, pow10_significand_table::compress ? -1 : 0)
@@ -0,0 +1,141 @@
+// Benchmark for https://github.com/vitaut/zmij/.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE).
+
+// Benchmarks the stages of zmij::write in isolation on precomputed inputs to
+// show where the time goes. Includes zmij.cc like zmij-test does to access
+// the internal functions.
+#include "../zmij.cc"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "benchmark.h"
+
+namespace {
+
+using traits = float_traits<double>;
+
+// The inputs of ::to_decimal for a finite nonzero double.
+struct binary {
+  uint64_t sig;
+  int64_t raw_exp;
+  bool regular;
+};
+
+// The inputs of write_decimal computed like in do_write.
+struct decimal_digits {
+  to_decimal_result dec;
+  dec_digits<64> dig;
+  bool has_last_digit;
+  bool has_extra_digit;
+  int dec_exp;
+};
+
+auto get_binary(const double* values, size_t count) -> std::vector<binary> {
+  std::vector<binary> result;
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto bits = traits::to_bits(values[i]);
+    auto bin_exp = traits::get_exp(bits);
+    auto bin_sig = traits::get_sig(bits);
+    if (bin_exp == traits::exp_mask || (bin_exp == 0 && bin_sig == 0))
+      continue;
+    if (bin_exp == 0)
+      result.push_back({bin_sig, 1, true});
+    else
+      result.push_back({bin_sig | traits::implicit_bit, bin_exp, bin_sig != 0});
+  }
+  return result;
+}
+
+auto to_decimal(const binary& b) -> to_decimal_result {
+  auto dec = ::to_decimal<double>(b.sig, b.raw_exp, b.regular,
+                                  static_data::value);
+  return b.sig >= traits::implicit_bit ? dec : normalize_subnormal<16>(dec);
+}
+
+auto get_decimal_digits(const double* values, size_t count)
+    -> std::vector<decimal_digits> {
+  std::vector<decimal_digits> result;
+  for (const binary& b : get_binary(values, count)) {
+    to_decimal_result dec = to_decimal(b);
+    bool has_extra_digit = uint64_t(dec.sig) >= static_data::value.threshold;
+    int dec_exp = dec.exp + traits::max_digits10 - 2 + has_extra_digit;
+    result.push_back({dec, to_digits<64>(dec.sig, static_data::value),
+                      dec.has_last_digit, has_extra_digit, dec_exp});
+  }
+  return result;
+}
+
+}  // namespace
+
+// Scaling the binary significand by a power of 10 and rounding.
+auto stage_to_decimal(benchmark::State& state, const double* values,
+                      size_t count) -> size_t {
+  auto inputs = get_binary(values, count);
+  for (auto _ : state) {
+    for (const binary& b : inputs) {
+      auto dec = ::to_decimal<double>(b.sig, b.raw_exp, b.regular,
+                                      static_data::value);
+      benchmark::DoNotOptimize(dec);
+    }
+  }
+  return inputs.size();
+}
+
+REGISTER_STAGE(to_decimal);
+
+// Converting the decimal significand to digits.
+auto stage_to_digits(benchmark::State& state, const double* values,
+                     size_t count) -> size_t {
+  std::vector<long long> inputs;
+  for (const binary& b : get_binary(values, count))
+    inputs.push_back(to_decimal(b).sig);
+  for (auto _ : state) {
+    for (long long sig : inputs) {
+      auto dig = to_digits<64>(sig, static_data::value);
+      benchmark::DoNotOptimize(dig);
+    }
+  }
+  return inputs.size();
+}
+
+REGISTER_STAGE(to_digits);
+
+// Writing the digits, the decimal point and the exponent in the fixed or
+// exponential notation.
+auto stage_write_decimal(benchmark::State& state, const double* values,
+                         size_t count) -> size_t {
+  auto inputs = get_decimal_digits(values, count);
+  char buffer[zmij::double_buffer_size];
+  for (auto _ : state) {
+    for (const decimal_digits& in : inputs) {
+      char* end = zmij::detail::write_decimal<double, default_policy<double>>(
+          buffer, in.dig, in.dec, in.has_last_digit, in.has_extra_digit,
+          in.dec_exp, &static_data::value);
+      benchmark::DoNotOptimize(end);
+      benchmark::ClobberMemory();
+    }
+  }
+  return inputs.size();
+}
+
+REGISTER_STAGE(write_decimal);
+
+// The whole conversion for comparison with the sum of the stages.
+auto stage_write(benchmark::State& state, const double* values, size_t count)
+    -> size_t {
+  char buffer[zmij::double_buffer_size];
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      char* end = zmij::detail::write(values[i], buffer);
+      benchmark::DoNotOptimize(end);
+      benchmark::ClobberMemory();
+    }
+  }
+  return count;
+}
+
+REGISTER_STAGE(write);
@@ -4,11 +4,21 @@
 
 // Include zmij.cc instead of linking with the library to test multiple
 // configurations without building multiple versions of the library and to test
-// internal functions.
+// internal functions. With ZMIJ_LIB=1, test the library through the public API.
+#ifndef ZMIJ_LIB
+#  define ZMIJ_LIB 0
+#endif
 #ifndef ZMIJ_C
 #  define ZMIJ_C 0
+#  include "../zmij-csv.h"
+#  include "../zmij-string.h"
 #  include "../zmij-to-chars.h"
-#  include "../zmij.cc"
+#  ifndef _WIN32
+#    include "../zmij-iovec.h"
+#  endif
+#  if !ZMIJ_LIB
+#    include "../zmij.cc"
+#  endif
 #else
 #  define _Alignas(x) alignas(x)
 #  include "../zmij.c"
@@ -32,9 +42,10 @@ auto write(char* out, size_t n, float value) noexcept -> char* {
 
 #include <stdint.h>  // uint64_t
 #include <stdio.h>   // snprintf
-#include <stdlib.h>  // atoi
+#include <stdlib.h>  // atoi, strtod
 #include <limits>    // std::numeric_limits
 #include <string>    // std::string
+#include <vector>    // std::vector
 
 #include "dragonbox/dragonbox_to_chars.h"
 #include "fmt/format.h"
@@ -53,6 +64,31 @@ auto ftoa(float value) -> std::string {
   return {buffer, end};
 }
 
+// Returns 64 pseudorandom bits from a linear congruential generator with a
+// fixed seed so that randomized tests are reproducible.
+auto random_bits() -> uint64_t {
+  static uint64_t state = 0x0123456789abcdef;
+  state = state * 6364136223846793005 + 1442695040888963407;
+  return state;
+}
+
+// Returns a double with pseudorandom bits, possibly a NaN or an infinity.
+auto random_double() -> double {
+  uint64_t bits = random_bits();
+  double value = 0;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Returns a float with pseudorandom bits, possibly a NaN or an infinity.
+auto random_float() -> float {
+  auto bits = uint32_t(random_bits() >> 32);
+  float value = 0;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+#if !ZMIJ_LIB
 TEST(zmij_test, utilities) {
   EXPECT_EQ(clz(1), 63);
   EXPECT_EQ(clz(~0ull), 0);
@@ -64,6 +100,7 @@ TEST(zmij_test, utilities) {
   EXPECT_EQ(count_trailing_nonzeros(0x01000000'00000000ull), 8);
   EXPECT_EQ(count_trailing_nonzeros(0x09000000'00000000ull), 8);
 }
+#endif
 
 TEST(double_test, normal) {
   EXPECT_EQ(dtoa(6.62607015e-34), "6.62607015e-34");
@@ -82,6 +119,23 @@ TEST(double_test, subnormal) {
   EXPECT_EQ(dtoa(2.2250738585072004e-308), "2.2250738585072004e-308");
 }
 
+TEST(double_test, subnormal_digit_counts) {
+  // Significands of all bit lengths give decimal significands of all digit
+  // counts which are normalized by different powers of 10.
+  for (int shift = 0; shift < 52; ++shift) {
+    uint64_t one = uint64_t(1) << shift;
+    for (uint64_t bits : {one, one | 1, (one << 1) - 1, one | (one >> 1)}) {
+      double value = 0;
+      memcpy(&value, &bits, sizeof(double));
+
+      char expected[32] = {};
+      *jkj::dragonbox::to_chars(value, expected) = '\0';
+
+      EXPECT_EQ(dtoa(value), expected) << bits;
+    }
+  }
+}
+
 TEST(double_test, write_irregular) {
   const char* fixed[] = {
       "0.0001220703125",
@@ -179,26 +233,36 @@ static const uint64_t boundary_bits[] = {
 #include "boundary-bits.h"
 };
 
+// Formats sig * 10**dec_exp, where sig has no trailing zeros, using fixed
+// notation for the exponents of the leading digit in [min_fixed_exp,
+// max_fixed_exp] and exponential notation otherwise.
+static auto to_string(uint64_t sig, int dec_exp, int min_fixed_exp = -4,
+                      int max_fixed_exp = 15, int min_exp_digits = 2,
+                      bool exp_plus = true, bool point_zero = false)
+    -> std::string {
+  std::string digits = std::to_string(sig);
+  int num_digits = int(digits.size());
+  dec_exp += num_digits - 1;  // exponent of the leading digit
+  if (dec_exp < min_fixed_exp || dec_exp > max_fixed_exp) {  // scientific
+    std::string sig_str = num_digits == 1
+                              ? digits
+                              : digits.substr(0, 1) + "." + digits.substr(1);
+    return sig_str + (exp_plus || dec_exp < 0
+                          ? fmt::format("e{:+0{}d}", dec_exp, min_exp_digits + 1)
+                          : fmt::format("e{:0{}d}", dec_exp, min_exp_digits));
+  }
+  int point = dec_exp + 1;  // digits left of the decimal point
+  if (point <= 0) return "0." + std::string(-point, '0') + digits;
+  if (point >= num_digits) {
+    return digits + std::string(point - num_digits, '0') +
+           (point_zero ? ".0" : "");
+  }
+  return digits.substr(0, point) + "." + digits.substr(point);
+}
+
 // Check zmij against dragonbox on every rounding-boundary double verify.py
 // enumerates, using dragonbox's to_decimal as an independent oracle.
 TEST(double_test, boundaries) {
-  auto to_string = [](uint64_t sig, int dec_exp) -> std::string {
-    std::string digits = std::to_string(sig);
-    int num_digits = int(digits.size());
-    dec_exp += num_digits - 1;           // exponent of the leading digit
-    if (dec_exp < -4 || dec_exp > 15) {  // scientific
-      std::string sig_str = num_digits == 1
-                                ? digits
-                                : digits.substr(0, 1) + "." + digits.substr(1);
-      return sig_str + fmt::format("e{:+03d}", dec_exp);
-    }
-    int point = dec_exp + 1;  // digits left of the decimal point
-    if (point <= 0) return "0." + std::string(-point, '0') + digits;
-    if (point >= num_digits)
-      return digits + std::string(point - num_digits, '0');
-    return digits.substr(0, point) + "." + digits.substr(point);
-  };
-
   for (uint64_t bits : boundary_bits) {
     double value = 0;
     memcpy(&value, &bits, sizeof(value));
@@ -290,6 +354,16 @@ void PrintTo(const dec_fp& d, std::ostream* os) {
 }
 }  // namespace zmij
 
+TEST(double_test, to_decimal_batch) {
+  std::vector<double> values = {0.0, -0.0, 1.0, 5e-324, 0x1p-1022,
+                                std::numeric_limits<double>::infinity()};
+  for (int i = 0; i < 10000; ++i) values.push_back(random_double());
+  std::vector<zmij::dec_fp> results(values.size());
+  zmij::to_decimal(values.data(), values.size(), results.data());
+  for (size_t i = 0; i < values.size(); ++i)
+    EXPECT_EQ(results[i], zmij::to_decimal(values[i])) << values[i];
+}
+
 static auto decimal(long long sig, int exp, bool negative = false)
     -> zmij::dec_fp {
   return {sig, exp, negative};
@@ -361,6 +435,575 @@ TEST(double_test, to_decimal_precision_irregular) {
     }
   }
 }
+
+TEST(double_test, write_as_float_if_exact) {
+  auto write = [](double value) {
+    char buffer[zmij::double_buffer_size];
+    auto end = zmij::write_as_float_if_exact(buffer, sizeof(buffer), value);
+    return std::string(buffer, end);
+  };
+  EXPECT_EQ(write(0.1f), "0.1");
+  EXPECT_EQ(write(-3.4028234663852886e+38), "-3.4028235e+38");
+  EXPECT_EQ(write(1.401298464324817e-45), "1e-45");  // float denorm_min
+  EXPECT_EQ(write(-0.0), "-0");
+
+  // Not representable as float.
+  EXPECT_EQ(write(0.1), "0.1");
+  EXPECT_EQ(write(0.1f + 0x1p-40), "0.10000000149102561");
+  EXPECT_EQ(write(1e39), "1e+39");
+  EXPECT_EQ(write(7e-46), "7e-46");
+  EXPECT_EQ(write(std::numeric_limits<double>::infinity()), "inf");
+  EXPECT_EQ(write(std::numeric_limits<double>::quiet_NaN()), "nan");
+}
+
+static auto write_capped(double value, int max_digits) -> std::string {
+  char buffer[zmij::double_buffer_size];
+  auto end =
+      zmij::write_shortest_capped(buffer, sizeof(buffer), value, max_digits);
+  return {buffer, end};
+}
+
+TEST(double_test, write_shortest_capped) {
+  EXPECT_EQ(write_capped(0.1, 1), "0.1");
+  EXPECT_EQ(write_capped(6.62607015e-34, 9), "6.62607015e-34");
+  EXPECT_EQ(write_capped(6.62607015e-34, 4), "6.626e-34");
+  EXPECT_EQ(write_capped(-1.2345678901234567e+123, 5), "-1.2346e+123");
+  EXPECT_EQ(write_capped(123456.7, 3), "123000");
+  EXPECT_EQ(write_capped(9.999, 2), "10");
+  EXPECT_EQ(write_capped(0.0009999, 3), "0.001");
+  EXPECT_EQ(write_capped(2.5, 1), "2");  // Round half to even.
+
+  // 0.15 is 0.1499999999999999944... so rounding the shortest digits would
+  // give 0.2.
+  EXPECT_EQ(write_capped(0.15, 1), "0.1");
+
+  // Ties of the shortest digits round the exact value.
+  EXPECT_EQ(write_capped(0.35, 1), "0.3");
+  EXPECT_EQ(write_capped(2.5e-5, 1), "3e-05");
+  EXPECT_EQ(write_capped(1.5e300, 1), "2e+300");
+
+  // Rounding carries into a new digit.
+  EXPECT_EQ(write_capped(999.96, 3), "1000");
+  EXPECT_EQ(write_capped(99999.5, 1), "100000");
+  EXPECT_EQ(write_capped(9.5, 1), "10");
+
+  // Rounding crosses the fixed/exponential boundary.
+  EXPECT_EQ(write_capped(9999999999999998.0, 16), "9999999999999998");
+  EXPECT_EQ(write_capped(9999999999999998.0, 1), "1e+16");
+  EXPECT_EQ(write_capped(9.999e-5, 3), "0.0001");
+  EXPECT_EQ(write_capped(9.999e-5, 4), "9.999e-05");
+
+  EXPECT_EQ(write_capped(0.1 + 0.2, 1), "0.3");
+  EXPECT_EQ(write_capped(0.1 + 0.2, 16), "0.3");
+  EXPECT_EQ(write_capped(0.1 + 0.2, 17), "0.30000000000000004");
+  EXPECT_EQ(write_capped(1.2345678901234568e+17, 1), "1e+17");
+  EXPECT_EQ(write_capped(1.2345678901234568e+17, 16), "1.234567890123457e+17");
+  EXPECT_EQ(write_capped(1.2345678901234568e+17, 17),
+            "1.2345678901234568e+17");
+
+  EXPECT_EQ(write_capped(1.24e-322, 2), "1.2e-322");  // subnormal
+  EXPECT_EQ(write_capped(0.0, 1), "0");
+  EXPECT_EQ(write_capped(std::numeric_limits<double>::infinity(), 1), "inf");
+
+  // Compare with the shortest output and snprintf rounding.
+  for (int i = 0; i < 10000; ++i) {
+    double value = random_double();
+    if (!(value - value == 0)) continue;  // NaN or infinity
+    long long sig = zmij::to_decimal(value).sig;
+    while (sig != 0 && sig % 10 == 0) sig /= 10;
+    int num_digits = 0;
+    for (; sig != 0; sig /= 10) ++num_digits;
+    for (int max_digits = 1; max_digits <= 17; ++max_digits) {
+      std::string result = write_capped(value, max_digits);
+      if (num_digits <= max_digits) {
+        EXPECT_EQ(result, dtoa(value));
+        continue;
+      }
+      char expected[32] = {};
+      snprintf(expected, sizeof(expected), "%.*e", max_digits - 1, value);
+      double rounded = strtod(expected, nullptr);
+      EXPECT_EQ(strtod(result.c_str(), nullptr), rounded)
+          << result << " " << expected;
+      // Up to 15 digits round trip so the output is the shortest one of the
+      // rounded value unless rounding overflows, e.g. to 2e+308.
+      if (max_digits <= 15 && rounded - rounded == 0) {
+        EXPECT_EQ(result, dtoa(rounded)) << expected;
+      }
+    }
+  }
+}
+
+template <typename Policy, typename Float>
+static auto write_with(Float value) -> std::string {
+  char buffer[zmij::double_buffer_size];
+  auto end = zmij::basic_write<Policy>(buffer, sizeof(buffer), value);
+  return {buffer, end};
+}
+
+// Replaces the point in `s` with `point` and, in fixed notation, separates
+// groups of three integer digits with `separator` unless it is 0.
+static auto localize(std::string s, char point, char separator)
+    -> std::string {
+  size_t pos = s.find('.');
+  if (pos != std::string::npos) s[pos] = point;
+  if (separator == 0 || s.find('e') != std::string::npos) return s;
+  if (pos == std::string::npos) pos = s.size();
+  size_t first_digit = s[0] == '-';
+  for (size_t i = pos; i > first_digit + 3; i -= 3)
+    s.insert(i - 3, 1, separator);
+  return s;
+}
+
+// Compares basic_write<Policy> with dragonbox on pseudorandom values.
+template <typename Policy, typename Float, typename UInt>
+static void check_policy() {
+  for (int i = 0; i < 100000; ++i) {
+    auto bits = UInt(random_bits() >> (64 - sizeof(UInt) * 8 + 1));  // positive
+    Float value = 0;
+    memcpy(&value, &bits, sizeof(value));
+    if (!(value < std::numeric_limits<Float>::infinity()) || value == 0)
+      continue;
+    auto ref = jkj::dragonbox::to_decimal(value);
+    auto expected =
+        to_string(ref.significand, ref.exponent, Policy::min_fixed_exp,
+                  Policy::max_fixed_exp, Policy::min_exp_digits,
+                  Policy::exp_plus, Policy::point_zero);
+    EXPECT_EQ(write_with<Policy>(value),
+              localize(expected, Policy::decimal_point,
+                       Policy::group_separator))
+        << "bits=" << bits;
+  }
+}
+
+#if !ZMIJ_LIB
+// Policies that are not instantiated in the library and need the header-only
+// mode.
+using widest_notation = zmij::write_policy<-15, 31>;
+using js_us = zmij::locale_policy<'.', ',', zmij::js_notation>;
+using py_de = zmij::locale_policy<',', '.', zmij::python_policy>;
+
+TEST(double_test, custom_policy) {
+  EXPECT_EQ(write_with<widest_notation>(1e31),
+            "10000000000000000000000000000000");
+  EXPECT_EQ(write_with<widest_notation>(-1.2345678901234568e-15),
+            "-0.0000000000000012345678901234568");
+  EXPECT_EQ(write_with<js_us>(123456789012345680000.0),
+            "123,456,789,012,345,680,000");
+  EXPECT_EQ(write_with<js_us>(1.2345678901234567e-6),
+            "0.0000012345678901234567");
+  EXPECT_EQ(write_with<py_de>(1000.0), "1.000,0");
+  EXPECT_EQ(write_with<py_de>(-0.0), "-0,0");
+  check_policy<widest_notation, double, uint64_t>();
+  check_policy<js_us, double, uint64_t>();
+  check_policy<py_de, double, uint64_t>();
+}
+
+TEST(float_test, custom_policy) {
+  EXPECT_EQ(write_with<widest_notation>(1e31f),
+            "10000000000000000000000000000000");
+  EXPECT_EQ(write_with<widest_notation>(-1.2345678e-15f),
+            "-0.0000000000000012345678");
+  check_policy<widest_notation, float, uint32_t>();
+  check_policy<js_us, float, uint32_t>();
+}
+#endif  // !ZMIJ_LIB
+
+TEST(double_test, basic_write) {
+  using zmij::exponential_notation;
+  using zmij::js_notation;
+  EXPECT_EQ(write_with<js_notation>(0.000001), "0.000001");
+  EXPECT_EQ(write_with<js_notation>(1.2345678901234567e-6),
+            "0.0000012345678901234567");
+  EXPECT_EQ(write_with<js_notation>(1e-7), "1e-07");
+  EXPECT_EQ(write_with<js_notation>(1e16), "10000000000000000");
+  EXPECT_EQ(write_with<js_notation>(1.2345678901234568e16),
+            "12345678901234568");
+  EXPECT_EQ(write_with<js_notation>(-1.2345678901234567e20),
+            "-123456789012345670000");
+  EXPECT_EQ(write_with<js_notation>(1e21), "1e+21");
+  EXPECT_EQ(write_with<js_notation>(-0.0), "-0");
+
+  EXPECT_EQ(write_with<exponential_notation>(1.5), "1.5e+00");
+  EXPECT_EQ(write_with<exponential_notation>(100.0), "1e+02");
+  EXPECT_EQ(write_with<exponential_notation>(0.001), "1e-03");
+
+  check_policy<js_notation, double, uint64_t>();
+  check_policy<exponential_notation, double, uint64_t>();
+}
+
+TEST(double_test, js_policy) {
+  // Output of Number.prototype.toString in V8.
+  struct {
+    double value;
+    const char* expected;
+  } tests[] = {
+      {0.0, "0"},
+      {-0.0, "0"},
+      {1.0, "1"},
+      {-1.5, "-1.5"},
+      {0.1, "0.1"},
+      {0.1 + 0.2, "0.30000000000000004"},
+      {4.35, "4.35"},
+      {0.000123, "0.000123"},
+      {1.2345e-5, "0.000012345"},
+      {0.000001, "0.000001"},
+      {1e-7, "1e-7"},
+      {1.5e-7, "1.5e-7"},
+      {1.23e-18, "1.23e-18"},
+      {123456789.12345679, "123456789.12345679"},
+      {9007199254740991.0, "9007199254740991"},
+      {9007199254740992.0, "9007199254740992"},
+      {18446744073709551616.0, "18446744073709552000"},
+      {1e20, "100000000000000000000"},
+      {123456789012345680000.0, "123456789012345680000"},
+      {1e21, "1e+21"},
+      {1.5e21, "1.5e+21"},
+      {1e100, "1e+100"},
+      {-1e301, "-1e+301"},
+      {2.220446049250313e-16, "2.220446049250313e-16"},
+      {5e-324, "5e-324"},
+      {1.7976931348623157e+308, "1.7976931348623157e+308"},
+      {std::numeric_limits<double>::infinity(), "Infinity"},
+      {-std::numeric_limits<double>::infinity(), "-Infinity"},
+      {std::numeric_limits<double>::quiet_NaN(), "NaN"},
+      {-std::numeric_limits<double>::quiet_NaN(), "NaN"},
+  };
+  for (auto test : tests)
+    EXPECT_EQ(write_with<zmij::js_policy>(test.value), test.expected);
+  check_policy<zmij::js_policy, double, uint64_t>();
+}
+
+TEST(double_test, python_policy) {
+  // Output of repr in CPython.
+  struct {
+    double value;
+    const char* expected;
+  } tests[] = {
+      {0.0, "0.0"},
+      {-0.0, "-0.0"},
+      {1.0, "1.0"},
+      {-1.5, "-1.5"},
+      {100.0, "100.0"},
+      {0.1, "0.1"},
+      {0.0001, "0.0001"},
+      {1e-05, "1e-05"},
+      {1.5e-05, "1.5e-05"},
+      {123456789.0, "123456789.0"},
+      {1e15, "1000000000000000.0"},
+      {9007199254740992.0, "9007199254740992.0"},
+      {1e16, "1e+16"},
+      {1.2345678901234568e16, "1.2345678901234568e+16"},
+      {-1e100, "-1e+100"},
+      {5e-324, "5e-324"},
+      {1.7976931348623157e+308, "1.7976931348623157e+308"},
+      {std::numeric_limits<double>::infinity(), "inf"},
+      {-std::numeric_limits<double>::infinity(), "-inf"},
+      {std::numeric_limits<double>::quiet_NaN(), "nan"},
+      {-std::numeric_limits<double>::quiet_NaN(), "nan"},
+  };
+  for (auto test : tests)
+    EXPECT_EQ(write_with<zmij::python_policy>(test.value), test.expected);
+  check_policy<zmij::python_policy, double, uint64_t>();
+}
+
+TEST(double_test, rust_policy) {
+  // Output of {:?} in Rust.
+  struct {
+    double value;
+    const char* expected;
+  } tests[] = {
+      {0.0, "0.0"},
+      {-0.0, "-0.0"},
+      {1.0, "1.0"},
+      {100.0, "100.0"},
+      {0.0001, "0.0001"},
+      {1e-05, "1e-5"},
+      {1.5e-05, "1.5e-5"},
+      {1e15, "1000000000000000.0"},
+      {1e16, "1e16"},
+      {1.2345678901234568e16, "1.2345678901234568e16"},
+      {1e22, "1e22"},
+      {-1e100, "-1e100"},
+      {5e-324, "5e-324"},
+      {1.7976931348623157e+308, "1.7976931348623157e308"},
+      {std::numeric_limits<double>::infinity(), "inf"},
+      {-std::numeric_limits<double>::infinity(), "-inf"},
+      {std::numeric_limits<double>::quiet_NaN(), "NaN"},
+      {-std::numeric_limits<double>::quiet_NaN(), "NaN"},
+  };
+  for (auto test : tests)
+    EXPECT_EQ(write_with<zmij::rust_policy>(test.value), test.expected);
+  check_policy<zmij::rust_policy, double, uint64_t>();
+}
+
+TEST(double_test, go_policy) {
+  // Output of strconv.FormatFloat(value, 'g', -1, 64) in Go.
+  struct {
+    double value;
+    const char* expected;
+  } tests[] = {
+      {0.0, "0"},
+      {-0.0, "-0"},
+      {1.0, "1"},
+      {0.0001, "0.0001"},
+      {1e-05, "1e-05"},
+      {123456.0, "123456"},
+      {1e6, "1e+06"},
+      {1234567.0, "1.234567e+06"},
+      {1e21, "1e+21"},
+      {-1e100, "-1e+100"},
+      {5e-324, "5e-324"},
+      {std::numeric_limits<double>::infinity(), "+Inf"},
+      {-std::numeric_limits<double>::infinity(), "-Inf"},
+      {std::numeric_limits<double>::quiet_NaN(), "NaN"},
+      {-std::numeric_limits<double>::quiet_NaN(), "NaN"},
+  };
+  for (auto test : tests)
+    EXPECT_EQ(write_with<zmij::go_policy>(test.value), test.expected);
+  check_policy<zmij::go_policy, double, uint64_t>();
+}
+
+// Pads `s` to `width` with `fill` like write_padded.
+static auto pad(std::string s, size_t width, char fill, zmij::align alignment)
+    -> std::string {
+  if (s.size() >= width) return s;
+  size_t n = width - s.size();
+  size_t before = alignment == zmij::align::left     ? 0
+                  : alignment == zmij::align::center ? n / 2
+                                                     : n;
+  return std::string(before, fill) + s + std::string(n - before, fill);
+}
+
+template <typename Float>
+static auto write_padded(Float value, size_t width, char fill = ' ',
+                         zmij::align alignment = zmij::align::right)
+    -> std::string {
+  std::string buffer(width + zmij::double_buffer_size, '?');
+  char* end = zmij::write_padded(&buffer[0], width, value, fill, alignment);
+  return {&buffer[0], end};
+}
+
+TEST(double_test, write_padded) {
+  using zmij::align;
+  EXPECT_EQ(write_padded(1.5, 6), "   1.5");
+  EXPECT_EQ(write_padded(-1.5, 6, '*', align::left), "-1.5**");
+  EXPECT_EQ(write_padded(1.5, 6, '_', align::center), "_1.5__");
+  EXPECT_EQ(write_padded(0.0, 3), "  0");
+  EXPECT_EQ(write_padded(-0.0, 4, '0'), "00-0");
+  EXPECT_EQ(write_padded(-std::numeric_limits<double>::infinity(), 6), "  -inf");
+  EXPECT_EQ(write_padded(1e300, 4), "1e+300");
+  EXPECT_EQ(write_padded(0.0001, 8, ' ', align::left), "0.0001  ");
+  EXPECT_EQ(write_padded(123456789012345.6, 20), "   123456789012345.6");
+  EXPECT_EQ(write_padded(-1.2345678901234568e-300, 30),
+            "      -1.2345678901234568e-300");
+  EXPECT_EQ(write_padded(5e-324, 0), "5e-324");
+
+  for (int i = 0; i < 100000; ++i) {
+    double value = random_double();
+    uint64_t bits = random_bits();
+    size_t width = bits % 28;
+    auto alignment = align((bits >> 8) % 3);
+    EXPECT_EQ(write_padded(value, width, '#', alignment),
+              pad(dtoa(value), width, '#', alignment))
+        << "value=" << dtoa(value);
+  }
+
+  double column[] = {1.0, -22.5, 0.125, 1e100};
+  char buffer[4 * 8 + zmij::double_buffer_size];
+  char* end = zmij::write_padded(buffer, 8, column, 4);
+  EXPECT_EQ(std::string(buffer, end),
+            "       1   -22.5   0.125  1e+100");
+}
+
+TEST(double_test, locale_policy) {
+  using comma = zmij::locale_policy<','>;
+  EXPECT_EQ(write_with<comma>(1.5), "1,5");
+  EXPECT_EQ(write_with<comma>(-0.001), "-0,001");
+  EXPECT_EQ(write_with<comma>(1234567.0), "1234567");
+  EXPECT_EQ(write_with<comma>(1.5e20), "1,5e+20");
+  EXPECT_EQ(write_with<comma>(1e-5), "1e-05");
+
+  using de = zmij::locale_policy<',', '.'>;
+  EXPECT_EQ(write_with<de>(0.0), "0");
+  EXPECT_EQ(write_with<de>(0.1), "0,1");
+  EXPECT_EQ(write_with<de>(123.25), "123,25");
+  EXPECT_EQ(write_with<de>(1000.0), "1.000");
+  EXPECT_EQ(write_with<de>(-1234567.5), "-1.234.567,5");
+  EXPECT_EQ(write_with<de>(0.30000000000000004), "0,30000000000000004");
+  EXPECT_EQ(write_with<de>(123456.78901234567), "123.456,78901234567");
+  EXPECT_EQ(write_with<de>(9007199254740991.0), "9.007.199.254.740.991");
+  EXPECT_EQ(write_with<de>(1e15), "1.000.000.000.000.000");
+  EXPECT_EQ(write_with<de>(1e16), "1e+16");
+
+  using us = zmij::locale_policy<'.', ','>;
+  EXPECT_EQ(write_with<us>(1234.5678), "1,234.5678");
+  EXPECT_EQ(write_with<us>(123456789012345680000.0), "1.2345678901234568e+20");
+
+  check_policy<comma, double, uint64_t>();
+  check_policy<de, double, uint64_t>();
+  check_policy<us, double, uint64_t>();
+}
+
+static auto write_int(long long value) -> std::string {
+  char buffer[zmij::double_buffer_size];
+  return {buffer, zmij::detail::write_int(value, buffer)};
+}
+
+TEST(zmij_test, write_int) {
+  EXPECT_EQ(write_int(0), "0");
+  EXPECT_EQ(write_int(-1), "-1");
+  EXPECT_EQ(write_int(99999999), "99999999");
+  EXPECT_EQ(write_int(100000000), "100000000");
+  EXPECT_EQ(write_int(10000000000000000), "10000000000000000");
+  EXPECT_EQ(write_int(std::numeric_limits<long long>::max()),
+            "9223372036854775807");
+  EXPECT_EQ(write_int(std::numeric_limits<long long>::min()),
+            "-9223372036854775808");
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t bits = random_bits();
+    auto value = static_cast<long long>(bits) >> (bits % 64);
+    EXPECT_EQ(write_int(value), std::to_string(value));
+  }
+}
+
+TEST(csv_test, write_row) {
+  zmij::csv_row_writer w;
+  w.write_row(std::string("x"), 1.5, 0.1f, 42, -7LL);
+  w.write_row("y", -0.0, 1e100, std::numeric_limits<double>::infinity());
+  w.write_row();
+  EXPECT_EQ(w.str(), "x,1.5,0.1,42,-7\ny,-0,1e+100,inf\n\n");
+
+  w.clear();
+  EXPECT_EQ(w.size(), 0u);
+  zmij::csv_row_writer tsv('\t');
+  std::string expected;
+  for (int i = 0; i < 1000; ++i) {
+    double value = i * 0.25;
+    tsv.write_row(i, value, static_cast<int64_t>(i) << 40);
+    expected += std::to_string(i) + '\t' + dtoa(value) + '\t' +
+                std::to_string(static_cast<int64_t>(i) << 40) + '\n';
+  }
+  EXPECT_EQ(std::string(tsv.data(), tsv.size()), expected);
+}
+
+// A buffer with resize_and_overwrite that counts resizes and reallocations.
+struct overwrite_buffer {
+  std::string data;
+  int num_resizes = 0;
+  int num_reserves = 0;
+
+  auto size() const -> size_t { return data.size(); }
+  auto capacity() const -> size_t { return data.capacity(); }
+  void reserve(size_t n) {
+    ++num_reserves;
+    data.reserve(n);
+  }
+  template <typename Op> void resize_and_overwrite(size_t n, Op op) {
+    ++num_resizes;
+    EXPECT_LE(n, data.capacity());
+    size_t size = data.size();
+    data.resize(n);
+    data.resize(op(&data[0], n));
+    EXPECT_GE(data.size(), size);
+  }
+};
+
+TEST(string_test, append) {
+  std::string s = "x";
+  zmij::append(s, 1.5);
+  zmij::append(s, 0.1f);
+  zmij::append(s, -std::numeric_limits<double>::infinity());
+  EXPECT_EQ(s, "x1.50.1-inf");
+
+  std::vector<char> v;
+  overwrite_buffer b;
+  std::string expected;
+  for (int i = 0; i < 1000; ++i) {
+    double value = (i - 500) * 1.0000000000000002e-3;
+    zmij::append(v, value);
+    zmij::append(b, value);
+    expected += dtoa(value);
+  }
+  EXPECT_EQ(std::string(v.data(), v.size()), expected);
+  EXPECT_EQ(b.data, expected);
+  EXPECT_EQ(b.num_resizes, 1000);
+  EXPECT_LE(b.num_reserves, 12);
+}
+
+#ifndef _WIN32
+TEST(iovec_test, write_iovec) {
+  double values[100];
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    values[i] = (i - 50) * 1.0000000000000002e10;
+    expected += dtoa(values[i]) + ',';
+  }
+  // Chunks of different sizes including one that is too small to be used.
+  char arena[2000];
+  iovec chunks[] = {{arena, 500}, {arena + 500, 20}, {arena + 520, 1480}};
+  iovec segments[3];
+  auto result = zmij::write_iovec(segments, chunks, 3, values, 100, ',');
+  EXPECT_EQ(result.num_values, 100u);
+  ASSERT_EQ(result.num_segments, 2u);
+  EXPECT_EQ(segments[0].iov_base, arena);
+  EXPECT_EQ(segments[1].iov_base, arena + 520);
+  std::string actual;
+  for (size_t i = 0; i < result.num_segments; ++i)
+    actual.append(static_cast<char*>(segments[i].iov_base), segments[i].iov_len);
+  EXPECT_EQ(actual, expected);
+
+  // Values that don't fit are not written.
+  result = zmij::write_iovec(segments, chunks, 1, values, 100);
+  EXPECT_EQ(result.num_segments, 1u);
+  size_t used = 0, num_values = 0;
+  while (500 - used > zmij::double_buffer_size)
+    used += dtoa(values[num_values++]).size() + 1;
+  EXPECT_EQ(result.num_values, num_values);
+  EXPECT_EQ(segments[0].iov_len, used);
+
+  float floats[] = {0.1f, -1.5f};
+  result = zmij::write_iovec(segments, chunks, 1, floats, 2);
+  EXPECT_EQ(std::string(arena, segments[0].iov_len), "0.1\n-1.5\n");
+}
+#endif  // _WIN32
+
+template <typename Float> static auto write_hex(Float value) -> std::string {
+  char buffer[zmij::hex_buffer_size + 1] = {};
+  memset(buffer, '?', sizeof(buffer));
+  auto end = zmij::write_hex(buffer, zmij::hex_buffer_size, value);
+  EXPECT_EQ(buffer[zmij::hex_buffer_size], '?');  // no overrun
+  return {buffer, end};
+}
+
+TEST(double_test, write_hex) {
+  EXPECT_EQ(write_hex(0.0), "0x0p+0");
+  EXPECT_EQ(write_hex(-0.0), "-0x0p+0");
+  EXPECT_EQ(write_hex(1.0), "0x1p+0");
+  EXPECT_EQ(write_hex(-0.5), "-0x1p-1");
+  EXPECT_EQ(write_hex(0.1), "0x1.999999999999ap-4");
+  EXPECT_EQ(write_hex(1.5), "0x1.8p+0");
+  EXPECT_EQ(write_hex(1024.0), "0x1p+10");
+  EXPECT_EQ(write_hex(-1.7976931348623157e+308), "-0x1.fffffffffffffp+1023");
+  EXPECT_EQ(write_hex(2.2250738585072014e-308), "0x1p-1022");
+  EXPECT_EQ(write_hex(-4.9406564584124654e-324), "-0x0.0000000000001p-1022");
+  EXPECT_EQ(write_hex(2.2250738585072009e-308), "0x0.fffffffffffffp-1022");
+  EXPECT_EQ(write_hex(std::numeric_limits<double>::infinity()), "inf");
+  EXPECT_EQ(write_hex(-std::numeric_limits<double>::infinity()), "-inf");
+  EXPECT_EQ(write_hex(std::numeric_limits<double>::quiet_NaN()), "nan");
+
+  char buffer[4];
+  EXPECT_EQ(zmij::write_hex(buffer, sizeof(buffer), 0.1) - buffer, 4);
+  EXPECT_EQ(std::string(buffer, sizeof(buffer)), "0x1.");
+
+#ifdef __GLIBC__
+  for (int i = 0; i < 100000; ++i) {
+    double value = random_double();
+    char expected[64];
+    snprintf(expected, sizeof(expected), "%a", value);
+    EXPECT_EQ(write_hex(value), expected);
+  }
+#endif
+}
 #endif  // !ZMIJ_C
 
 TEST(float_test, normal) {
@@ -371,6 +1014,15 @@ TEST(float_test, normal) {
 
 TEST(float_test, subnormal) {
   EXPECT_EQ(ftoa(std::numeric_limits<float>::denorm_min()), "1e-45");
+  for (uint32_t bits = 1; bits < (1u << 23); bits = bits * 3 + 1) {
+    float value = 0;
+    memcpy(&value, &bits, sizeof(float));
+
+    char expected[32] = {};
+    *jkj::dragonbox::to_chars(value, expected) = '\0';
+
+    EXPECT_EQ(ftoa(value), expected) << bits;
+  }
 }
 
 TEST(float_test, no_overrun) {
@@ -417,6 +1069,26 @@ TEST(float_test, to_decimal_precision) {
   EXPECT_EQ(
       to_decimal(std::numeric_limits<float>::max(), 9), decimal(340282347, 30)
   );  // FLT_MAX
+
+  // Exact ties scaled by an inexact power of 10 (dec_exp > 0).
+  EXPECT_EQ(to_decimal(25.0f, 1), decimal(2, 1));
+  EXPECT_EQ(to_decimal(35.0f, 1), decimal(4, 1));
+  EXPECT_EQ(to_decimal(4.5e5f, 1), decimal(4, 5));
+  EXPECT_EQ(to_decimal(1.5e7f, 1), decimal(2, 7));
+}
+
+TEST(float_test, to_decimal_precision_irregular) {
+  for (uint32_t exp = 1; exp <= 254; ++exp) {
+    uint32_t bits = exp << 23;
+    float value = 0;
+    memcpy(&value, &bits, sizeof(float));
+    for (int precision = 1; precision <= 18; ++precision) {
+      EXPECT_EQ(
+          zmij::to_decimal(value, precision), expected_decimal(value, precision)
+      ) << "value="
+        << value << " precision=" << precision;
+    }
+  }
 }
 
 TEST(float_test, fixed_with_zeros) {
@@ -424,8 +1096,113 @@ TEST(float_test, fixed_with_zeros) {
   EXPECT_EQ(ftoa(43210.1f), "43210.1");
   EXPECT_EQ(ftoa(10000.f), "10000");
 }
+
+TEST(float_test, write_shortest_capped) {
+  auto write = [](float value, int max_digits) {
+    char buffer[zmij::float_buffer_size];
+    auto end =
+        zmij::write_shortest_capped(buffer, sizeof(buffer), value, max_digits);
+    return std::string(buffer, end);
+  };
+  EXPECT_EQ(write(0.1f, 1), "0.1");
+  EXPECT_EQ(write(6.62607e-34f, 3), "6.63e-34");
+  EXPECT_EQ(write(3.4028235e+38f, 3), "3.4e+38");
+  EXPECT_EQ(write(16777216.0f, 4), "1.678e+07");
+  EXPECT_EQ(write(999999.9f, 6), "1000000");
+  EXPECT_EQ(write(std::numeric_limits<float>::denorm_min(), 1), "1e-45");
+  EXPECT_EQ(write(-1.00000005e+15f, 8), "-1.0000001e+15");
+}
+
+TEST(float_test, basic_write) {
+  using zmij::exponential_notation;
+  using zmij::js_notation;
+  EXPECT_EQ(write_with<js_notation>(0.1f), "0.1");
+  EXPECT_EQ(write_with<js_notation>(1.5e-6f), "0.0000015");
+  EXPECT_EQ(write_with<js_notation>(16777216.0f), "16777216");
+  EXPECT_EQ(write_with<js_notation>(-1e10f), "-10000000000");
+  EXPECT_EQ(write_with<js_notation>(3.4028235e+38f), "3.4028235e+38");
+  EXPECT_EQ(write_with<exponential_notation>(1.5f), "1.5e+00");
+
+  check_policy<js_notation, float, uint32_t>();
+  check_policy<exponential_notation, float, uint32_t>();
+  check_policy<zmij::js_policy, float, uint32_t>();
+  check_policy<zmij::python_policy, float, uint32_t>();
+  check_policy<zmij::rust_policy, float, uint32_t>();
+  check_policy<zmij::go_policy, float, uint32_t>();
+  EXPECT_EQ(write_with<zmij::rust_policy>(3.4028235e38f), "3.4028235e38");
+  EXPECT_EQ(write_with<zmij::python_policy>(16777216.0f), "16777216.0");
+}
+
+TEST(float_test, write_padded) {
+  EXPECT_EQ(write_padded(1.5f, 6), "   1.5");
+  EXPECT_EQ(write_padded(-3.4028235e+38f, 16), "  -3.4028235e+38");
+  EXPECT_EQ(write_padded(1677721.6f, 10, ' ', zmij::align::left),
+            "1677721.6 ");
+  EXPECT_EQ(write_padded(1e-45f, 8), "   1e-45");
+  for (int i = 0; i < 100000; ++i) {
+    float value = random_float();
+    uint64_t bits = random_bits();
+    size_t width = bits % 20;
+    auto alignment = zmij::align((bits >> 8) % 3);
+    EXPECT_EQ(write_padded(value, width, ' ', alignment),
+              pad(ftoa(value), width, ' ', alignment))
+        << "value=" << ftoa(value);
+  }
+  float column[] = {1.0f, 0.1f};
+  char buffer[2 * 5 + zmij::double_buffer_size];
+  EXPECT_EQ(std::string(buffer, zmij::write_padded(buffer, 5, column, 2, ' ',
+                                                   zmij::align::left)),
+            "1    0.1  ");
+}
+
+TEST(float_test, locale_policy) {
+  using de = zmij::locale_policy<',', '.'>;
+  EXPECT_EQ(write_with<de>(1234567.5f), "1.234.567,5");
+  EXPECT_EQ(write_with<de>(16777216.0f), "16.777.216");
+  EXPECT_EQ(write_with<de>(0.1f), "0,1");
+  EXPECT_EQ(write_with<de>(1.5e20f), "1,5e+20");
+  check_policy<zmij::locale_policy<','>, float, uint32_t>();
+  check_policy<de, float, uint32_t>();
+}
+
+TEST(float_test, write_hex) {
+  EXPECT_EQ(write_hex(0.1f), "0x1.99999ap-4");
+  EXPECT_EQ(write_hex(-3.4028235e+38f), "-0x1.fffffep+127");
+  EXPECT_EQ(write_hex(1e-45f), "0x1p-149");
+  EXPECT_EQ(write_hex(std::numeric_limits<float>::infinity()), "inf");
+}
 #endif  // !ZMIJ_C
 
+#if ZMIJ_ENABLE_STATS
+TEST(stats_test, paths) {
+  uint32_t short_float_bits = 0x02000005;  // 9.40396e-38f
+  float short_float = 0;
+  memcpy(&short_float, &short_float_bits, sizeof(short_float));
+
+  auto before = zmij::stats();
+  dtoa(1.5);                                         // fixed
+  dtoa(1.0);                                         // irregular, fixed
+  dtoa(std::numeric_limits<double>::denorm_min());  // subnormal, exponential
+  dtoa(1.2345678901234567e+123);                     // last digit, exponential
+  ftoa(short_float);                                 // short float, exponential
+  dtoa(-0.0);                                        // zero
+  dtoa(std::numeric_limits<double>::quiet_NaN());    // non-finite
+  auto after = zmij::stats();
+  EXPECT_EQ(after.writes - before.writes, 7);
+  EXPECT_EQ(after.zero - before.zero, 1);
+  EXPECT_EQ(after.non_finite - before.non_finite, 1);
+  EXPECT_EQ(after.irregular - before.irregular, 1);
+  EXPECT_EQ(after.subnormal - before.subnormal, 1);
+  EXPECT_EQ(after.fixed - before.fixed, 2);
+  EXPECT_EQ(after.exponential - before.exponential, 3);
+  EXPECT_EQ(after.extra_digit - before.extra_digit, 3);
+  EXPECT_EQ(after.last_digit - before.last_digit, 1);
+  EXPECT_EQ(after.short_float - before.short_float, 1);
+  EXPECT_EQ(after.writes, after.zero + after.non_finite + after.fixed +
+                              after.exponential);
+}
+#endif  // ZMIJ_ENABLE_STATS
+
 auto main(int argc, char** argv) -> int {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,134 @@
+// A double-to-string conversion algorithm based on Schubfach.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE) or alternatively
+// the Boost Software License, Version 1.0.
+
+#ifndef ZMIJ_CSV_H_
+#define ZMIJ_CSV_H_
+
+#include <stddef.h>  // size_t
+#include <string.h>  // memcpy
+
+#include <string>  // std::string
+
+#include "zmij.h"
+
+namespace zmij {
+
+/// Writes rows of delimiter-separated fields to a growable buffer. Fields can
+/// be doubles and floats written like `write`, integers, and strings written
+/// as is without quoting. The capacity is checked once per row against the
+/// combined maximum size of its fields rather than once per field.
+/// Usage:
+///   zmij::csv_row_writer w;
+///   w.write_row("x", 1.5, 42);  // "x,1.5,42\n"
+class csv_row_writer {
+ private:
+  std::string buffer_;  // Only the first size_ characters are written.
+  size_t size_ = 0;
+  char delimiter_;
+
+  // The maximum number of characters written for a field.
+  static auto max_size(double) noexcept -> size_t {
+    return double_buffer_size;
+  }
+  static auto max_size(float) noexcept -> size_t { return float_buffer_size; }
+  // Integers are written as long long in groups of 8 digits which fits in
+  // the double buffer size.
+  static auto max_size(int) noexcept -> size_t { return double_buffer_size; }
+  static auto max_size(long) noexcept -> size_t { return double_buffer_size; }
+  static auto max_size(long long) noexcept -> size_t {
+    return double_buffer_size;
+  }
+  static auto max_size(const std::string& s) noexcept -> size_t {
+    return s.size();
+  }
+  static auto max_size(const char* s) noexcept -> size_t { return strlen(s); }
+#ifdef __cpp_lib_string_view
+  static auto max_size(std::string_view s) noexcept -> size_t {
+    return s.size();
+  }
+#endif
+
+  static auto write_field(char* out, double value) noexcept -> char* {
+    return detail::write(value, out);
+  }
+  static auto write_field(char* out, float value) noexcept -> char* {
+    return detail::write(value, out);
+  }
+  static auto write_field(char* out, int value) noexcept -> char* {
+    return detail::write_int(value, out);
+  }
+  static auto write_field(char* out, long value) noexcept -> char* {
+    return detail::write_int(value, out);
+  }
+  static auto write_field(char* out, long long value) noexcept -> char* {
+    return detail::write_int(value, out);
+  }
+  static auto write_field(char* out, const std::string& s) noexcept -> char* {
+    memcpy(out, s.data(), s.size());
+    return out + s.size();
+  }
+  static auto write_field(char* out, const char* s) noexcept -> char* {
+    size_t size = strlen(s);
+    memcpy(out, s, size);
+    return out + size;
+  }
+#ifdef __cpp_lib_string_view
+  static auto write_field(char* out, std::string_view s) noexcept -> char* {
+    memcpy(out, s.data(), s.size());
+    return out + s.size();
+  }
+#endif
+
+  // Returns a pointer to at least n characters past the written ones.
+  auto reserve(size_t n) -> char* {
+    if (buffer_.size() - size_ < n) {
+      size_t capacity = buffer_.size() * 2;
+      buffer_.resize(capacity > size_ + n ? capacity : size_ + n);
+    }
+    return &buffer_[size_];
+  }
+
+  auto write_fields(char* out) const noexcept -> char* { return out; }
+
+  template <typename T, typename... Tail>
+  auto write_fields(char* out, const T& field, const Tail&... tail) const
+      noexcept -> char* {
+    out = write_field(out, field);
+    *out++ = delimiter_;
+    return write_fields(out, tail...);
+  }
+
+ public:
+  explicit csv_row_writer(char delimiter = ',') noexcept
+      : delimiter_(delimiter) {}
+
+  /// Writes a row of fields terminated by a newline.
+  template <typename... T> void write_row(const T&... fields) {
+    size_t sizes[] = {max_size(fields)..., 1};  // 1 for an empty row
+    size_t size = sizeof...(T);                  // delimiters and the newline
+    for (size_t s : sizes) size += s;
+    char* start = reserve(size);
+    char* end = write_fields(start, fields...);
+    if (end == start) *end++ = delimiter_;  // an empty row
+    end[-1] = '\n';
+    size_ += size_t(end - start);
+  }
+
+  /// Returns a pointer to the written rows which are not null-terminated.
+  auto data() const noexcept -> const char* { return buffer_.data(); }
+
+  /// Returns the number of characters written.
+  auto size() const noexcept -> size_t { return size_; }
+
+  /// Returns the written rows as a string.
+  auto str() const -> std::string { return buffer_.substr(0, size_); }
+
+  /// Discards the written rows keeping the allocated buffer.
+  void clear() noexcept { size_ = 0; }
+};
+
+}  // namespace zmij
+
+#endif  // ZMIJ_CSV_H_
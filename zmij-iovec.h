@@ -0,0 +1,69 @@
+// A double-to-string conversion algorithm based on Schubfach.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE) or alternatively
+// the Boost Software License, Version 1.0.
+
+#ifndef ZMIJ_IOVEC_H_
+#define ZMIJ_IOVEC_H_
+
+#include <stddef.h>   // size_t
+#include <sys/uio.h>  // iovec
+
+#include "zmij.h"
+
+namespace zmij {
+
+struct write_iovec_result {
+  size_t num_segments;  // the number of iovecs stored in segments
+  size_t num_values;    // the number of values written
+};
+
+namespace detail {
+template <typename Float, int buffer_size>
+auto write_iovec(iovec* segments, const iovec* chunks, size_t num_chunks,
+                 const Float* values, size_t count, char delimiter) noexcept
+    -> write_iovec_result {
+  write_iovec_result result = {0, 0};
+  for (size_t i = 0; i < num_chunks && result.num_values < count; ++i) {
+    char* start = static_cast<char*>(chunks[i].iov_base);
+    char* p = start;
+    char* end = start + chunks[i].iov_len;
+    // Each value is followed by the delimiter so it takes at most
+    // buffer_size + 1 characters including the write's scratch space.
+    while (result.num_values < count && end - p > buffer_size) {
+      p = detail::write(values[result.num_values++], p);
+      *p++ = delimiter;
+    }
+    if (p != start) segments[result.num_segments++] = {start, size_t(p - start)};
+  }
+  return result;
+}
+}  // namespace detail
+
+/// Writes `values` like `write`, each followed by `delimiter`, directly into
+/// the caller-provided buffers `chunks` and stores an iovec for the output in
+/// each used chunk to `segments`, which must have room for `num_chunks`
+/// entries, ready for writev or sendmsg. A chunk is filled while it has room
+/// for `double_buffer_size + 1` characters. Returns the numbers of segments
+/// and values written; values that don't fit in the chunks are not written.
+inline auto write_iovec(iovec* segments, const iovec* chunks,
+                        size_t num_chunks, const double* values, size_t count,
+                        char delimiter = '\n') noexcept -> write_iovec_result {
+  return detail::write_iovec<double, double_buffer_size>(
+      segments, chunks, num_chunks, values, count, delimiter);
+}
+
+/// Writes `values` like `write`, each followed by `delimiter`, directly into
+/// `chunks` and stores an iovec for the output in each used chunk to
+/// `segments`. A chunk is filled while it has room for
+/// `float_buffer_size + 1` characters.
+inline auto write_iovec(iovec* segments, const iovec* chunks,
+                        size_t num_chunks, const float* values, size_t count,
+                        char delimiter = '\n') noexcept -> write_iovec_result {
+  return detail::write_iovec<float, float_buffer_size>(
+      segments, chunks, num_chunks, values, count, delimiter);
+}
+
+}  // namespace zmij
+
+#endif  // ZMIJ_IOVEC_H_
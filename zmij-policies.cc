@@ -0,0 +1,11 @@
+// Instantiations of the output policies, write_shortest_capped and
+// write_padded for the zmij-policies library.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE) or alternatively
+// the Boost Software License, Version 1.0.
+// https://github.com/vitaut/zmij/
+
+// They are kept out of zmij.cc so that programs which only call zmij::write
+// don't link them.
+#define ZMIJ_POLICIES 1
+#include "zmij.cc"
@@ -0,0 +1,80 @@
+// A double-to-string conversion algorithm based on Schubfach.
+// Copyright (c) 2025 - present, Victor Zverovich
+// Distributed under the MIT license (see LICENSE) or alternatively
+// the Boost Software License, Version 1.0.
+
+#ifndef ZMIJ_STRING_H_
+#define ZMIJ_STRING_H_
+
+#include <stddef.h>  // size_t
+#include <string.h>  // memcpy
+
+#include <type_traits>  // std::true_type
+#include <utility>      // std::declval
+
+#include "zmij.h"
+
+namespace zmij {
+namespace detail {
+
+// Detects the C++23 resize_and_overwrite member function which resizes a
+// buffer without initializing the new characters.
+template <typename Buffer, typename = void>
+struct has_resize_and_overwrite : std::false_type {};
+template <typename Buffer>
+struct has_resize_and_overwrite<
+    Buffer, decltype(std::declval<Buffer&>().resize_and_overwrite(
+                         size_t(), std::declval<size_t (*)(char*, size_t)>()),
+                     void())> : std::true_type {};
+
+// Makes sure buf has capacity for size characters growing it geometrically
+// because reserve may allocate exactly the requested capacity.
+template <typename Buffer> void grow(Buffer& buf, size_t size) {
+  size_t capacity = buf.capacity();
+  if (size > capacity) buf.reserve(size > capacity * 2 ? size : capacity * 2);
+}
+
+template <int buffer_size, typename Buffer, typename Float>
+void append(Buffer& buf, Float value, std::true_type) {
+  size_t size = buf.size();
+  grow(buf, size + buffer_size);
+  buf.resize_and_overwrite(size + buffer_size, [=](char* p, size_t) {
+    return size_t(detail::write(value, p + size) - p);
+  });
+}
+
+template <int buffer_size, typename Buffer, typename Float>
+void append(Buffer& buf, Float value, std::false_type) {
+  // Write to a temporary buffer to resize only once to the exact size
+  // instead of zero-filling the maximum size and shrinking.
+  char digits[buffer_size];
+  size_t n = size_t(detail::write(value, digits) - digits);
+  size_t size = buf.size();
+  grow(buf, size + n);
+  buf.resize(size + n);
+  memcpy(&buf[0] + size, digits, n);
+}
+
+}  // namespace detail
+
+/// Appends `value` written like `write` to `buf`, a contiguous growable
+/// buffer of characters such as `std::string` or `std::vector<char>` that
+/// provides `size`, `capacity`, `reserve`, `resize` and `operator[]`.
+/// The capacity grows geometrically and the buffer is resized once per value.
+/// If `buf` has `resize_and_overwrite` (`std::string` in C++23), the value is
+/// written in place without zero-filling.
+template <typename Buffer> void append(Buffer& buf, double value) {
+  detail::append<double_buffer_size>(
+      buf, value, detail::has_resize_and_overwrite<Buffer>());
+}
+
+/// Appends `value` written like `write` to `buf`, a contiguous growable
+/// buffer of characters.
+template <typename Buffer> void append(Buffer& buf, float value) {
+  detail::append<float_buffer_size>(
+      buf, value, detail::has_resize_and_overwrite<Buffer>());
+}
+
+}  // namespace zmij
+
+#endif  // ZMIJ_STRING_H_
@@ -322,6 +322,35 @@ static ZMIJ_INLINE uint64_t div10(uint64_t x) {
   return ZMIJ_USE_INT128 ? umul128_hi64(x, div10_sig64) : x / 10;
 }
 
+static const uint64_t pow10s[] = {
+    1,
+    10,
+    100,
+    1000,
+    10000,
+    100000,
+    1000000,
+    10000000,
+    100000000,
+    1000000000,
+    10000000000,
+    100000000000,
+    1000000000000,
+    10000000000000,
+    100000000000000,
+    1000000000000000,
+    10000000000000000,
+    100000000000000000,
+    1000000000000000000,
+};
+
+// Returns the number of decimal digits in n > 0 without a loop.
+static ZMIJ_INLINE int count_digits(uint64_t n) {
+  // floor(log10(2**bit_length)) from the bit length: 1233 / 2**12 ~ log10(2).
+  int t = (64 - clz(n)) * 1233 >> 12;
+  return t + (n >= pow10s[t]);
+}
+
 // Returns true_value if condition != 0, else false_value, without branching.
 static ZMIJ_INLINE int64_t zmij_select(uint64_t condition, int64_t true_value,
                                        int64_t false_value) {
@@ -1197,54 +1226,112 @@ typedef struct {
   unsigned char shift_pos;
   // Offset past end of fixed-notation output, indexed by sig length - 1.
   unsigned char end_pos[17];
+#if ZMIJ_USE_SSE4_1
+  // Buffer-relative position of the last_digit byte, indexed by extra_digit.
+  unsigned char last_digit_pos[2];
+  // pshufb table mapping BCD bytes to their output slots; the decimal-point
+  // slot (if any) holds a zero-marker (high bit set). Indexed by extra_digit.
+  // Read via aligned load (_mm_load_si128), so must be 16-byte aligned.
+  ZMIJ_ALIGNAS(16) unsigned char shuffle[2][16];
+#endif
 } fixed_layout_entry;
 
-#if ZMIJ_AARCH64 && !ZMIJ_OPTIMIZE_SIZE
+#if ZMIJ_USE_SSE4_1
+// The shuffle tables are built from natural-order BCD (to_digits_double puts
+// BCD[k] at byte k). extra_digit == 0 drops the leading zero, so digits start
+// at BCD[!extra_digit]; the point goes after the digit for 10**dec_exp.
+#  define ZMIJ_POINT_SLOT(dec_exp) \
+    ((dec_exp) >= 0 && (dec_exp) <= 14 ? 1 + (dec_exp) : 128)
+#  define ZMIJ_SHUFFLE_INDEX(dec_exp, extra, i) \
+    ((i) == ZMIJ_POINT_SLOT(dec_exp)           \
+         ? 0xFF                                 \
+         : !(extra) + (i) - ((i) > ZMIJ_POINT_SLOT(dec_exp)))
+#  define ZMIJ_SHUFFLE(e, x)                                                  \
+    {ZMIJ_SHUFFLE_INDEX(e, x, 0),  ZMIJ_SHUFFLE_INDEX(e, x, 1),              \
+     ZMIJ_SHUFFLE_INDEX(e, x, 2),  ZMIJ_SHUFFLE_INDEX(e, x, 3),              \
+     ZMIJ_SHUFFLE_INDEX(e, x, 4),  ZMIJ_SHUFFLE_INDEX(e, x, 5),              \
+     ZMIJ_SHUFFLE_INDEX(e, x, 6),  ZMIJ_SHUFFLE_INDEX(e, x, 7),              \
+     ZMIJ_SHUFFLE_INDEX(e, x, 8),  ZMIJ_SHUFFLE_INDEX(e, x, 9),              \
+     ZMIJ_SHUFFLE_INDEX(e, x, 10), ZMIJ_SHUFFLE_INDEX(e, x, 11),             \
+     ZMIJ_SHUFFLE_INDEX(e, x, 12), ZMIJ_SHUFFLE_INDEX(e, x, 13),             \
+     ZMIJ_SHUFFLE_INDEX(e, x, 14), ZMIJ_SHUFFLE_INDEX(e, x, 15)}
+#  define ZMIJ_LAST_DIGIT_POS(dec_exp, extra) \
+    (15 + (extra) + ((dec_exp) >= 0 && (dec_exp) < 15 + (extra)))
+#  define ZMIJ_FIXED_SHUFFLES(e)                               \
+    , {ZMIJ_LAST_DIGIT_POS(e, 0), ZMIJ_LAST_DIGIT_POS(e, 1)}, \
+        {ZMIJ_SHUFFLE(e, 0), ZMIJ_SHUFFLE(e, 1)}
+#else
+#  define ZMIJ_FIXED_SHUFFLES(e)
+#endif  // ZMIJ_USE_SSE4_1
+
+#if ZMIJ_USE_SSE4_1
+ZMIJ_ALIGNAS(64)  // Align to a cache line.
+#elif ZMIJ_AARCH64 && !ZMIJ_OPTIMIZE_SIZE
 // Align to 32 bytes so indexing uses `lsl #5` not `umaddl`.
 ZMIJ_ALIGNAS(32)
 #endif
 static const fixed_layout_entry fixed_layout_table[20] = {
     // clang-format off
     {5, 1, 1,  // -4
-     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}},
+     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}
+     ZMIJ_FIXED_SHUFFLES(-4)},
     {4, 1, 1,  // -3
-     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}},
+     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}
+     ZMIJ_FIXED_SHUFFLES(-3)},
     {3, 1, 1,  // -2
-     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}},
+     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}
+     ZMIJ_FIXED_SHUFFLES(-2)},
     {2, 1, 1,  // -1
-     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}},
+     {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}
+     ZMIJ_FIXED_SHUFFLES(-1)},
     {0, 1, 2,  //  0
-     {1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(0)},
     {0, 2, 3,  //  1
-     {2, 2, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {2, 2, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(1)},
     {0, 3, 4,  //  2
-     {3, 3, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {3, 3, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(2)},
     {0, 4, 5,  //  3
-     {4, 4, 4, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {4, 4, 4, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(3)},
     {0, 5, 6,  //  4
-     {5, 5, 5, 5, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {5, 5, 5, 5, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(4)},
     {0, 6, 7,  //  5
-     {6, 6, 6, 6, 6, 6, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {6, 6, 6, 6, 6, 6, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(5)},
     {0, 7, 8,  //  6
-     {7, 7, 7, 7, 7, 7, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {7, 7, 7, 7, 7, 7, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(6)},
     {0, 8, 9,  //  7
-     {8, 8, 8, 8, 8, 8, 8, 8, 10, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {8, 8, 8, 8, 8, 8, 8, 8, 10, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(7)},
     {0, 9, 10,  //  8
-     {9, 9, 9, 9, 9, 9, 9, 9, 9, 11, 12, 13, 14, 15, 16, 17, 18}},
+     {9, 9, 9, 9, 9, 9, 9, 9, 9, 11, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(8)},
     {0, 10, 11,  //  9
-     {10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 12, 13, 14, 15, 16, 17, 18}},
+     {10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 12, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(9)},
     {0, 11, 12,  // 10
-     {11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 13, 14, 15, 16, 17, 18}},
+     {11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 13, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(10)},
     {0, 12, 13,  // 11
-     {12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 14, 15, 16, 17, 18}},
+     {12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 14, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(11)},
     {0, 13, 14,  // 12
-     {13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 15, 16, 17, 18}},
+     {13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 15, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(12)},
     {0, 14, 15,  // 13
-     {14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 16, 17, 18}},
+     {14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 16, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(13)},
     {0, 15, 16,  // 14
-     {15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 17, 18}},
+     {15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 17, 18}
+     ZMIJ_FIXED_SHUFFLES(14)},
     {0, 16, 17,  // 15
-     {16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 18}},
+     {16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 18}
+     ZMIJ_FIXED_SHUFFLES(15)},
     // clang-format on
 };
 
@@ -2101,15 +2188,14 @@ static ZMIJ_INLINE char* do_write(uint64_t bin_sig, int64_t bin_exp,
                          : to_decimal_float((uint32_t)bin_sig, 1, true);
     long long dec_sig =
         dec.sig * 10 + (-(int)dec.has_last_digit & dec.last_digit);
-    int dec_exp = dec.exp;
-    while ((uint64_t)dec_sig < threshold) {
-      dec_sig *= 10;
-      --dec_exp;
-    }
+    // Scale to threshold or above with one multiplication instead of a loop.
+    int scale = (num_bits == 64 ? 16 : 8) - count_digits((uint64_t)dec_sig);
+    scale = scale > 0 ? scale : 0;
+    dec_sig *= (long long)pow10s[scale];
     long long q = div10(dec_sig);
     int last_digit = (int)(dec_sig - q * 10);
     dec.sig = q;
-    dec.exp = dec_exp;
+    dec.exp -= scale;
     dec.last_digit = last_digit;
     dec.has_last_digit = last_digit != 0;
   } else {
@@ -2143,6 +2229,22 @@ static ZMIJ_INLINE char* do_write(uint64_t bin_sig, int64_t bin_exp,
         &fixed_layouts[dec_exp - double_min_fixed_dec_exp];
     buffer += layout->start_pos;
     int num_digits;
+#if ZMIJ_USE_SSE4_1
+    if (num_bits == 64) {
+      dec_digits_double dig = to_digits_double(dec.sig);
+      __m128i tbl =
+          _mm_load_si128((const __m128i*)layout->shuffle[extra_digit]);
+      __m128i out = _mm_shuffle_epi8(dig.digits, tbl);
+      memcpy(buffer, &out, bcd_size);  // Store the assembled digits in one go.
+      // The point can push BCD[15] outside the vector to buffer[16], so write
+      // it unconditionally (otherwise it's in-vector or overwritten below).
+      buffer[bcd_size] = (char)_mm_extract_epi8(dig.digits, 15);
+      start[layout->point_pos] = '.';
+      buffer[layout->last_digit_pos[extra_digit]] = last_digit_char;
+      num_digits = has_last_digit ? bcd_size : dig.num_digits - 1;
+      return buffer + layout->end_pos[num_digits + extra_digit - 1];
+    }
+#endif  // ZMIJ_USE_SSE4_1
     if (num_bits == 64) {
       dec_digits_double dig = to_digits_double(dec.sig);
       write_digits_double(buffer, dig.digits, !extra_digit);
@@ -4,6 +4,9 @@
 // the Boost Software License, Version 1.0.
 // https://github.com/vitaut/zmij/
 
+#ifndef ZMIJ_CC_
+#define ZMIJ_CC_
+
 #if __has_include("zmij.h")
 #  include "zmij.h"
 #else
@@ -130,6 +133,11 @@ static_assert(!ZMIJ_USE_SSE4_1 || ZMIJ_USE_SSE);
 #ifndef ZMIJ_USE_EXP_STRING_TABLE
 #  define ZMIJ_USE_EXP_STRING_TABLE ZMIJ_OPTIMIZE_SIZE == 0
 #endif
+// Write the significand of doubles in exponential notation with one shuffle.
+// Off by default because it is not faster than the scalar stores on x86-64.
+#ifndef ZMIJ_USE_EXP_DOUBLE_SHUFFLE
+#  define ZMIJ_USE_EXP_DOUBLE_SHUFFLE 0
+#endif
 
 #if ZMIJ_HAS_ATTRIBUTE(always_inline) && !ZMIJ_OPTIMIZE_SIZE
 #  define ZMIJ_INLINE __attribute__((always_inline)) inline
@@ -139,6 +147,39 @@ static_assert(!ZMIJ_USE_SSE4_1 || ZMIJ_USE_SSE);
 #  define ZMIJ_INLINE inline
 #endif
 
+// Non-template API functions are inline in the header-only mode.
+#if ZMIJ_HEADER_ONLY
+#  define ZMIJ_FUNC inline
+#else
+#  define ZMIJ_FUNC
+#endif
+
+// zmij-policies.cc includes this file with ZMIJ_POLICIES=1 to instantiate the
+// templates that are not in the main library. The non-template functions are
+// then omitted since the main library defines them.
+#ifndef ZMIJ_POLICIES
+#  define ZMIJ_POLICIES 0
+#endif
+
+#if ZMIJ_ENABLE_STATS
+#  define ZMIJ_COUNT(counter) ++zmij::detail::thread_stats().counter
+#else
+#  define ZMIJ_COUNT(counter) (void)0
+#endif
+
+// Define ZMIJ_USE_USDT=1 to add SystemTap/USDT probes (nops until attached) at
+// entry to and return from write and to_decimal. For example:
+//   bpftrace -e 'usdt:./example:zmij:write_return { @len = hist(arg1); }'
+#ifndef ZMIJ_USE_USDT
+#  define ZMIJ_USE_USDT 0
+#endif
+#if ZMIJ_USE_USDT
+#  include <sys/sdt.h>
+#  define ZMIJ_PROBE(name, arg1, arg2) DTRACE_PROBE2(zmij, name, arg1, arg2)
+#else
+#  define ZMIJ_PROBE(name, arg1, arg2) (void)0
+#endif
+
 #ifdef __GNUC__
 #  define ZMIJ_ASM(x) asm x
 #else
@@ -155,7 +196,21 @@ static_assert(!ZMIJ_USE_SSE4_1 || ZMIJ_USE_SSE);
 #  define ZMIJ_CONST_DECL static constexpr
 #endif
 
-namespace {
+// Hides the internals from the dynamic symbol table so that shared libraries
+// access the tables directly rather than through the GOT.
+#if ZMIJ_HAS_ATTRIBUTE(visibility) && !defined(_WIN32)
+#  define ZMIJ_HIDDEN __attribute__((visibility("hidden")))
+#else
+#  define ZMIJ_HIDDEN
+#endif
+
+// The internals are in a named namespace rather than an unnamed one because
+// inline functions with external linkage such as detail::write may not use
+// entities with internal linkage if they are defined in more than one
+// translation unit, i.e. in the header-only mode or in zmij.cc and
+// zmij-policies.cc. It is inline so that the internals can be referred to as
+// ::name in both cases.
+inline namespace zmij_detail ZMIJ_HIDDEN {
 
 #ifdef __cpp_lib_is_constant_evaluated
 using std::is_constant_evaluated;
@@ -381,73 +436,94 @@ template <typename Float> struct float_traits : std::numeric_limits<Float> {
   }
 };
 
-constexpr long long pow10s[] = {
-    1,
-    10,
-    100,
-    1'000,
-    10'000,
-    100'000,
-    1'000'000,
-    10'000'000,
-    100'000'000,
-    1'000'000'000,
-    10'000'000'000,
-    100'000'000'000,
-    1'000'000'000'000,
-    10'000'000'000'000,
-    100'000'000'000'000,
-    1'000'000'000'000'000,
-    10'000'000'000'000'000,
-    100'000'000'000'000'000,
-    1'000'000'000'000'000'000,
+// Constants are static members of class templates rather than variables so
+// that there is one instance of each in all translation units even without
+// C++17 inline variables.
+template <typename T> struct constant {
+  static constexpr T value = {};
 };
+template <typename T> constexpr T constant<T>::value;
+
+template <typename T = void> struct pow10_tables {
+  static constexpr long long pow10s[] = {
+      1,
+      10,
+      100,
+      1'000,
+      10'000,
+      100'000,
+      1'000'000,
+      10'000'000,
+      100'000'000,
+      1'000'000'000,
+      10'000'000'000,
+      100'000'000'000,
+      1'000'000'000'000,
+      10'000'000'000'000,
+      100'000'000'000'000,
+      1'000'000'000'000'000,
+      10'000'000'000'000'000,
+      100'000'000'000'000'000,
+      1'000'000'000'000'000'000,
+  };
 
-constexpr uint64_t pow10_minor[] = {
-    0x8000000000000000, 0xa000000000000000, 0xc800000000000000,
-    0xfa00000000000000, 0x9c40000000000000, 0xc350000000000000,
-    0xf424000000000000, 0x9896800000000000, 0xbebc200000000000,
-    0xee6b280000000000, 0x9502f90000000000, 0xba43b74000000000,
-    0xe8d4a51000000000, 0x9184e72a00000000, 0xb5e620f480000000,
-    0xe35fa931a0000000, 0x8e1bc9bf04000000, 0xb1a2bc2ec5000000,
-    0xde0b6b3a76400000, 0x8ac7230489e80000, 0xad78ebc5ac620000,
-    0xd8d726b7177a8000, 0x878678326eac9000, 0xa968163f0a57b400,
-    0xd3c21bcecceda100, 0x84595161401484a0, 0xa56fa5b99019a5c8,
-    0xcecb8f27f4200f3a,
-};
-constexpr uint128 pow10_major[] = {
-    {0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3e},  // -331 (+1 ULP: see fixups)
-    {0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dda},  // -303
-    {0xb1442798f49ffb4a, 0x99cd11cfdf41779d},  // -275
-    {0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15},  // -247
-    {0xb4bca50b065abe63, 0x0fed077a756b53aa},  // -219
-    {0xb67f6455292cbf08, 0x1a3bc84c17b1d543},  // -191
-    {0xb84687c269ef3bfb, 0x3d5d514f40eea742},  // -163
-    {0xba121a4650e4ddeb, 0x92f34d62616ce413},  // -135
-    {0xbbe226efb628afea, 0x890489f70a55368c},  // -107
-    {0xbdb6b8e905cb600f, 0x5400e987bbc1c921},  //  -79
-    {0xbf8fdb78849a5f96, 0xde98520472bdd034},  //  -51
-    {0xc16d9a0095928a27, 0x75b7053c0f178294},  //  -23
-    {0xc350000000000000, 0x0000000000000000},  //    5
-    {0xc5371912364ce305, 0x6c28000000000000},  //   33
-    {0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef6},  //   61
-    {0xc913936dd571c84c, 0x03bc3a19cd1e38ea},  //   89
-    {0xcb090c8001ab551c, 0x5cadf5bfd3072cc6},  //  117
-    {0xcd036837130890a1, 0x36dba887c37a8c10},  //  145
-    {0xcf02b2c21207ef2e, 0x94f967e45e03f4bc},  //  173
-    {0xd106f86e69d785c7, 0xe13336d701beba52},  //  201
-    {0xd31045a8341ca07c, 0x1ede48111209a051},  //  229
-    {0xd51ea6fa85785631, 0x552a74227f3ea566},  //  257
-    {0xd732290fbacaf133, 0xa97c177947ad4096},  //  285
-    {0xd94ad8b1c7380874, 0x18375281ae7822bd},  //  313 (+1 ULP: see fixups)
-    {0xdb68c2ca82ed2a05, 0xa67398db9f6820e1},  //  341
+  static constexpr uint64_t pow10_minor[] = {
+      0x8000000000000000, 0xa000000000000000, 0xc800000000000000,
+      0xfa00000000000000, 0x9c40000000000000, 0xc350000000000000,
+      0xf424000000000000, 0x9896800000000000, 0xbebc200000000000,
+      0xee6b280000000000, 0x9502f90000000000, 0xba43b74000000000,
+      0xe8d4a51000000000, 0x9184e72a00000000, 0xb5e620f480000000,
+      0xe35fa931a0000000, 0x8e1bc9bf04000000, 0xb1a2bc2ec5000000,
+      0xde0b6b3a76400000, 0x8ac7230489e80000, 0xad78ebc5ac620000,
+      0xd8d726b7177a8000, 0x878678326eac9000, 0xa968163f0a57b400,
+      0xd3c21bcecceda100, 0x84595161401484a0, 0xa56fa5b99019a5c8,
+      0xcecb8f27f4200f3a,
+  };
+  static constexpr uint128 pow10_major[] = {
+      {0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3e},  // -331 (+1 ULP: see fixups)
+      {0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dda},  // -303
+      {0xb1442798f49ffb4a, 0x99cd11cfdf41779d},  // -275
+      {0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15},  // -247
+      {0xb4bca50b065abe63, 0x0fed077a756b53aa},  // -219
+      {0xb67f6455292cbf08, 0x1a3bc84c17b1d543},  // -191
+      {0xb84687c269ef3bfb, 0x3d5d514f40eea742},  // -163
+      {0xba121a4650e4ddeb, 0x92f34d62616ce413},  // -135
+      {0xbbe226efb628afea, 0x890489f70a55368c},  // -107
+      {0xbdb6b8e905cb600f, 0x5400e987bbc1c921},  //  -79
+      {0xbf8fdb78849a5f96, 0xde98520472bdd034},  //  -51
+      {0xc16d9a0095928a27, 0x75b7053c0f178294},  //  -23
+      {0xc350000000000000, 0x0000000000000000},  //    5
+      {0xc5371912364ce305, 0x6c28000000000000},  //   33
+      {0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef6},  //   61
+      {0xc913936dd571c84c, 0x03bc3a19cd1e38ea},  //   89
+      {0xcb090c8001ab551c, 0x5cadf5bfd3072cc6},  //  117
+      {0xcd036837130890a1, 0x36dba887c37a8c10},  //  145
+      {0xcf02b2c21207ef2e, 0x94f967e45e03f4bc},  //  173
+      {0xd106f86e69d785c7, 0xe13336d701beba52},  //  201
+      {0xd31045a8341ca07c, 0x1ede48111209a051},  //  229
+      {0xd51ea6fa85785631, 0x552a74227f3ea566},  //  257
+      {0xd732290fbacaf133, 0xa97c177947ad4096},  //  285
+      {0xd94ad8b1c7380874, 0x18375281ae7822bd},  //  313 (+1 ULP: see fixups)
+      {0xdb68c2ca82ed2a05, 0xa67398db9f6820e1},  //  341
+  };
+  static constexpr uint32_t pow10_fixups[] = {
+      0x8d8fc810, 0x06100293, 0x19000000, 0x00100000, 0x00000908,
+      0x00000000, 0x04e00300, 0x3807e0b2, 0x3d83d793, 0x0006f5cc,
+      0x00000000, 0xffff0000, 0x8076337d, 0x4ff45ba0, 0x09405033,
+      0x034376d9, 0x09000000, 0x4e100501, 0x076d14dc, 0xf964f45e,
+      0x0000003d};
 };
-constexpr uint32_t pow10_fixups[] = {
-    0x8d8fc810, 0x06100293, 0x19000000, 0x00100000, 0x00000908,
-    0x00000000, 0x04e00300, 0x3807e0b2, 0x3d83d793, 0x0006f5cc,
-    0x00000000, 0xffff0000, 0x8076337d, 0x4ff45ba0, 0x09405033,
-    0x034376d9, 0x09000000, 0x4e100501, 0x076d14dc, 0xf964f45e,
-    0x0000003d};
+template <typename T> constexpr long long pow10_tables<T>::pow10s[];
+template <typename T> constexpr uint64_t pow10_tables<T>::pow10_minor[];
+template <typename T> constexpr uint128 pow10_tables<T>::pow10_major[];
+template <typename T> constexpr uint32_t pow10_tables<T>::pow10_fixups[];
+
+// Returns the number of decimal digits in n > 0 without a loop.
+inline auto count_digits(uint64_t n) noexcept -> int {
+  // floor(log10(2**bit_length)) from the bit length: 1233 / 2**12 ~ log10(2).
+  int t = (64 - clz(n)) * 1233 >> 12;
+  return t + (n >= uint64_t(pow10_tables<>::pow10s[t]));
+}
 
 // 128-bit significands of powers of 10 rounded down.
 struct pow10_significand_table {
@@ -458,9 +534,11 @@ struct pow10_significand_table {
 
   // Computes the 128-bit significand of 10**i using method by Dougall Johnson.
   static constexpr auto compute(unsigned i) noexcept -> uint128 {
-    constexpr int stride = sizeof(pow10_minor) / sizeof(*pow10_minor);
-    auto m = pow10_minor[(i + 24) % stride];
-    auto h = pow10_major[(i + 24) / stride];
+    using tables = pow10_tables<>;
+    constexpr int stride =
+        sizeof(tables::pow10_minor) / sizeof(*tables::pow10_minor);
+    auto m = tables::pow10_minor[(i + 24) % stride];
+    auto h = tables::pow10_major[(i + 24) / stride];
 
     uint64_t h1 = umul128_hi64(h.lo, m);
 
@@ -471,7 +549,7 @@ struct pow10_significand_table {
     uint128 result = (c2 >> 63) != 0
                          ? uint128{c2, c1}
                          : uint128{c2 << 1 | c1 >> 63, c1 << 1 | c0 >> 63};
-    result.lo -= (pow10_fixups[i >> 5] >> (i & 31)) & 1;
+    result.lo -= (tables::pow10_fixups[i >> 5] >> (i & 31)) & 1;
     return result;
   }
 
@@ -545,7 +623,10 @@ struct exp_shift_table {
 
 // An optional table of precomputed exponent strings for exponential notation.
 // Each entry packs "e+dd" or "e+ddd" into a uint64_t with the length in byte 7.
-struct exp_string_table {
+// The exponent is padded with zeros to min_exp_digits digits and the '+' sign
+// is omitted unless exp_plus is set.
+template <int min_exp_digits, bool exp_plus = true>
+struct basic_exp_string_table {
   static constexpr bool enable = ZMIJ_USE_EXP_STRING_TABLE;
   using traits = float_traits<double>;
   static constexpr int min_dec_exp =
@@ -553,18 +634,21 @@ struct exp_string_table {
   static constexpr int offset = -min_dec_exp;
   uint64_t data[enable ? traits::max_exponent10 - min_dec_exp + 1 : 1] = {};
 
-  constexpr exp_string_table() {
+  constexpr basic_exp_string_table() {
     for (int e = min_dec_exp; e <= traits::max_exponent10 && enable; ++e) {
       uint64_t abs_e = e >= 0 ? e : -e;
-      uint64_t bc = abs_e % 100;
-      uint64_t val = ((bc % 10 + '0') << 8) | (bc / 10 + '0');
-      if (uint64_t a = abs_e / 100) val = (val << 8) | (a + '0');
-      uint64_t len = 4 + (abs_e >= 100);
-      data[e + offset] =
-          (len << 48) | (val << 16) | (uint64_t(e >= 0 ? '+' : '-') << 8) | 'e';
+      int num_digits = abs_e >= 100 ? 3 : abs_e >= 10 ? 2 : 1;
+      if (num_digits < min_exp_digits) num_digits = min_exp_digits;
+      uint64_t val = 0;
+      for (int i = 0; i < num_digits; ++i, abs_e /= 10)
+        val = (val << 8) | (abs_e % 10 + '0');
+      if (e < 0 || exp_plus) val = (val << 8) | (e >= 0 ? '+' : '-');
+      uint64_t len = 1 + num_digits + (e < 0 || exp_plus);
+      data[e + offset] = (len << 48) | (val << 8) | 'e';
     }
   }
 };
+using exp_string_table = basic_exp_string_table<2>;
 
 // Shuffle vectors to build strings for exponential notation.
 //
@@ -627,6 +711,24 @@ struct exp_float_shuffle_table {
   }
 };
 
+// Shuffle vectors to write the significand of a double in exponential
+// notation: the leading digit, a zeroed byte for the point and the next 14
+// digits, indexed by has_extra_digit. Without an extra digit BCD[0] is '0' and
+// the leading digit is BCD[1].
+struct exp_double_shuffle_table {
+  static constexpr bool enable = ZMIJ_USE_EXP_DOUBLE_SHUFFLE &&
+                                 (ZMIJ_USE_SSE4_1 || ZMIJ_USE_NEON) &&
+                                 exp_string_table::enable;
+  alignas(16) unsigned char data[enable ? 2 : 1][16] = {};
+
+  constexpr exp_double_shuffle_table() {
+    for (int extra = 0; extra < 2 && enable; ++extra) {
+      unsigned char bcd_idx = !extra;
+      for (int i = 0; i < 16; ++i) data[extra][i] = i == 1 ? 0x80 : bcd_idx++;
+    }
+  }
+};
+
 constexpr auto fixed_entry_align() noexcept -> int {
   if (ZMIJ_USE_SSE4_1) return 64;  // Align to a cache line.
   // Align entry to 32 bytes so indexing uses `lsl #5` not `umaddl`.
@@ -635,11 +737,13 @@ constexpr auto fixed_entry_align() noexcept -> int {
 
 // Per-decimal-exponent buffer layout for branchless fixed-notation output.
 // Each entry holds the byte positions of the leading zeros, decimal point,
-// and end of output, indexed by the decimal exponent (dec_exp).
-struct fixed_layout_table {
+// and end of output, indexed by the decimal exponent (dec_exp) in
+// [min_dec_exp, max_dec_exp]. Entries don't depend on the range, so a table
+// can serve any policy whose fixed range it covers.
+template <int min_dec_exp, int max_dec_exp> struct fixed_layout_table {
   using traits = float_traits<double>;
-  static constexpr int num_entries =
-      traits::max_fixed_dec_exp - traits::min_fixed_dec_exp + 1;
+  static constexpr int min_exp = min_dec_exp, max_exp = max_dec_exp;
+  static constexpr int num_entries = max_dec_exp - min_dec_exp + 1;
 
   struct alignas(fixed_entry_align()) entry {
 #if ZMIJ_USE_SSE4_1
@@ -664,9 +768,8 @@ struct fixed_layout_table {
   entry data[num_entries] = {};
 
   constexpr fixed_layout_table() {
-    for (int dec_exp = traits::min_fixed_dec_exp;
-         dec_exp <= traits::max_fixed_dec_exp; ++dec_exp) {
-      auto& e = data[dec_exp - traits::min_fixed_dec_exp];
+    for (int dec_exp = min_dec_exp; dec_exp <= max_dec_exp; ++dec_exp) {
+      auto& e = data[dec_exp - min_dec_exp];
 
       e.start_pos = dec_exp < -0 ? 1 - dec_exp : 0;
       e.point_pos = dec_exp >= 0 ? 1 + dec_exp : 1;
@@ -699,9 +802,101 @@ struct fixed_layout_table {
   }
 
   constexpr auto get(int dec_exp) const noexcept -> const entry& {
-    constexpr auto min = traits::min_fixed_dec_exp;
-    assert(dec_exp >= min && dec_exp <= traits::max_fixed_dec_exp);
-    return data[unsigned(dec_exp - min)];
+    assert(dec_exp >= min_dec_exp && dec_exp <= max_dec_exp);
+    return data[unsigned(dec_exp - min_dec_exp)];
+  }
+};
+
+using default_fixed_layout_table =
+    fixed_layout_table<float_traits<double>::min_fixed_dec_exp,
+                       float_traits<double>::max_fixed_dec_exp>;
+
+// A layout table for fixed notation with a decimal point other than '.' or
+// with digit grouping. Unlike fixed_layout_table it describes all of the
+// (up to 32) output bytes following the sign, so that the digits and the
+// punctuation, including leading and trailing zeros, are placed by a single
+// table-driven shuffle instead of inserting the separators afterwards.
+template <int min_dec_exp, int max_dec_exp, int bcd_size, char decimal_point,
+          char group_separator, int group_size>
+struct punct_layout_table {
+  static constexpr int size = 32;
+  static constexpr int num_entries = max_dec_exp - min_dec_exp + 1;
+
+  // Returns the number of output bytes taken by the integer part and the
+  // point, or by "0." and the leading zeros for dec_exp < 0.
+  static constexpr auto prefix_size(int dec_exp) noexcept -> int {
+    if (dec_exp < 0) return 1 - dec_exp;
+    return dec_exp + 2 + (group_separator != 0 ? dec_exp / group_size : 0);
+  }
+  static_assert(prefix_size(min_dec_exp) + float_traits<double>::max_digits10 <=
+                        size &&
+                    prefix_size(max_dec_exp) <= size,
+                "fixed notation must fit in 32 bytes");
+
+  struct alignas(16) entry {
+    // Source indices for pshufb/tbl indexed by has_extra_digit: BCD indices
+    // for digits and 0x80 for the bytes taken from punct.
+    unsigned char shuffle[2][size];
+    // Bytes combined with the shuffled digits by OR: separators, the point
+    // and '0' elsewhere which leaves digits unchanged and fills in zeros.
+    char punct[size];
+    unsigned char point_pos;
+    // Position of the last digit which is not in BCD by has_extra_digit.
+    unsigned char last_digit_pos[2];
+    // Offset past the end of fixed-notation output, indexed by sig length - 1.
+    unsigned char end_pos[float_traits<double>::max_digits10];
+  };
+  entry data[num_entries] = {};
+
+  // Returns the output position of the significant digit with index i.
+  static constexpr auto digit_pos(int dec_exp, int i) noexcept -> int {
+    if (dec_exp < 0) return 1 - dec_exp + i;
+    int num_int_digits = dec_exp + 1;
+    if (i >= num_int_digits) return prefix_size(dec_exp) + i - num_int_digits;
+    if (group_separator == 0) return i;
+    // Groups are counted from the point, so the first one may be shorter.
+    return i + (i + group_size - num_int_digits % group_size) / group_size -
+           (num_int_digits % group_size == 0);
+  }
+
+  constexpr punct_layout_table() {
+    for (int dec_exp = min_dec_exp; dec_exp <= max_dec_exp; ++dec_exp) {
+      auto& e = data[dec_exp - min_dec_exp];
+      int point_pos = dec_exp < 0 ? 1 : prefix_size(dec_exp) - 1;
+      e.point_pos = point_pos;
+
+      // Digits are in ['0', '9'] so they can be combined with '0' by OR.
+      for (int i = 0; i < size; ++i) {
+        e.shuffle[0][i] = e.shuffle[1][i] = 0x80;
+        e.punct[i] = '0';
+      }
+      e.punct[point_pos] = decimal_point;
+      for (int i = 1; i <= dec_exp && group_separator != 0; ++i) {
+        if ((dec_exp + 1 - i) % group_size == 0)
+          e.punct[digit_pos(dec_exp, i) - 1] = group_separator;
+      }
+
+      for (int i = 0; digit_pos(dec_exp, i) < size; ++i) {
+        int pos = digit_pos(dec_exp, i);
+        for (int extra = 0; extra < 2; ++extra) {
+          // Without an extra digit BCD[0] is '0' and digits start at BCD[1].
+          int bcd_index = i + !extra;
+          if (bcd_index < bcd_size) e.shuffle[extra][pos] = bcd_index;
+          if (bcd_index == bcd_size) e.last_digit_pos[extra] = pos;
+        }
+      }
+
+      for (int n = 1; n <= float_traits<double>::max_digits10; ++n) {
+        e.end_pos[n - 1] =
+            dec_exp >= 0 && n <= dec_exp + 1 ? point_pos
+                                             : digit_pos(dec_exp, n - 1) + 1;
+      }
+    }
+  }
+
+  constexpr auto get(int dec_exp) const noexcept -> const entry& {
+    assert(dec_exp >= min_dec_exp && dec_exp <= max_dec_exp);
+    return data[unsigned(dec_exp - min_dec_exp)];
   }
 };
 
@@ -756,7 +951,7 @@ inline auto write_if(char* buffer, uint32_t digit, bool condition) noexcept
   return buffer + condition;
 }
 
-struct data {
+struct alignas(64) data {
   static constexpr auto splat64(uint64_t x) -> uint128 { return {x, x}; }
   static constexpr auto splat32(uint32_t x) -> uint128 {
     return splat64(uint64_t(x) << 32 | x);
@@ -808,15 +1003,144 @@ struct data {
   exp_shift_table exp_shifts;
   exp_string_table exp_strings;
   alignas(64) pow10_significand_table pow10_significands;
-  fixed_layout_table fixed_layouts;
+  default_fixed_layout_table fixed_layouts;
   exp_float_shuffle_table exp_float_shuffles;
+  exp_double_shuffle_table exp_double_shuffles;
 
   // Shuffle indices for SIMD digit shift. Offset 0 = identity, offset 1 =
   // shift left by 1 (drops the leading '0' of a 16-digit significand).
   unsigned char shift_shuffle[17] = {0, 1,  2,  3,  4,  5,  6,  7, 8,
                                      9, 10, 11, 12, 13, 14, 15, 0};
 };
-alignas(64) constexpr data static_data;
+using static_data = constant<data>;
+
+// An output policy: fixed notation is used for the decimal exponents (of the
+// leading digit) in [min_fixed_exp, max_fixed_exp], exponential otherwise.
+// Exponents are padded to min_exp_digits and have a '+' sign if exp_plus is
+// set, zero is written as "-0" if negative and signed_zero is set, integers
+// in fixed notation end with ".0" if point_zero is set, the point is
+// decimal_point, integer digits in fixed notation are split into groups of
+// group_size by group_separator unless it is 0, and the functions give the
+// non-finite strings including the sign. This one is used by write.
+template <typename Float> struct default_policy {
+  enum {
+    min_fixed_exp = float_traits<Float>::min_fixed_dec_exp,
+    max_fixed_exp = float_traits<Float>::max_fixed_dec_exp,
+    min_exp_digits = 2,
+    exp_plus = 1,
+    signed_zero = 1,
+    point_zero = 0,
+    decimal_point = '.',
+    group_separator = 0,
+    group_size = 3,
+  };
+  static constexpr auto inf() noexcept -> const char* { return "inf"; }
+  static constexpr auto neg_inf() noexcept -> const char* { return "-inf"; }
+  static constexpr auto nan() noexcept -> const char* { return "nan"; }
+  static constexpr auto neg_nan() noexcept -> const char* { return "-nan"; }
+};
+
+// Layout tables for the policies with fixed ranges outside of the default one.
+template <int min_dec_exp, int max_dec_exp>
+using policy_fixed_layouts =
+    constant<fixed_layout_table<min_dec_exp, max_dec_exp>>;
+
+template <typename Policy>
+ZMIJ_INLINE auto get_fixed_layouts(const data& d, std::true_type) noexcept
+    -> const default_fixed_layout_table* {
+  return &d.fixed_layouts;
+}
+
+template <typename Policy>
+ZMIJ_INLINE auto get_fixed_layouts(const data&, std::false_type) noexcept
+    -> const fixed_layout_table<Policy::min_fixed_exp, Policy::max_fixed_exp>* {
+  return &policy_fixed_layouts<Policy::min_fixed_exp,
+                               Policy::max_fixed_exp>::value;
+}
+
+// Returns the layout table for the fixed range of Policy, preferring the one
+// in static_data which is likely to be in cache.
+template <typename Policy>
+ZMIJ_INLINE auto get_fixed_layouts(const data& d) noexcept {
+  using table = default_fixed_layout_table;
+  constexpr bool use_default = int(Policy::min_fixed_exp) >= table::min_exp &&
+                               int(Policy::max_fixed_exp) <= table::max_exp;
+  return get_fixed_layouts<Policy>(d,
+                                   std::integral_constant<bool, use_default>());
+}
+
+template <int min_exp_digits, bool exp_plus>
+using policy_exp_strings =
+    constant<basic_exp_string_table<min_exp_digits, exp_plus>>;
+
+template <typename Policy, int bcd_size>
+using punct_layout_table_for =
+    punct_layout_table<Policy::min_fixed_exp, Policy::max_fixed_exp, bcd_size,
+                       char(Policy::decimal_point),
+                       char(Policy::group_separator), Policy::group_size>;
+
+template <typename Policy, int bcd_size>
+using policy_punct_layouts = constant<punct_layout_table_for<Policy, bcd_size>>;
+
+// Returns the exponent string table for Policy.
+template <typename Policy>
+ZMIJ_INLINE auto get_exp_strings(const data& d, std::true_type) noexcept
+    -> const exp_string_table* {
+  return &d.exp_strings;
+}
+
+template <typename Policy>
+ZMIJ_INLINE auto get_exp_strings(const data&, std::false_type) noexcept
+    -> const basic_exp_string_table<Policy::min_exp_digits,
+                                    Policy::exp_plus != 0>* {
+  return &policy_exp_strings<Policy::min_exp_digits,
+                             Policy::exp_plus != 0>::value;
+}
+
+template <typename Policy>
+ZMIJ_INLINE auto get_exp_strings(const data& d) noexcept {
+  constexpr bool use_default =
+      Policy::min_exp_digits == 2 && Policy::exp_plus != 0;
+  return get_exp_strings<Policy>(d,
+                                 std::integral_constant<bool, use_default>());
+}
+
+constexpr auto equal(const char* lhs, const char* rhs) noexcept -> bool {
+  for (; *lhs == *rhs; ++lhs, ++rhs) {
+    if (!*lhs) return true;
+  }
+  return false;
+}
+
+// Appends ".0" to integers in fixed notation if required by Policy. `end` and
+// `point` point to the end of the output and the position of the point.
+template <typename Policy>
+ZMIJ_INLINE auto write_point_zero(char* end, const char* point) noexcept
+    -> char* {
+  if (!Policy::point_zero) return end;
+  end[0] = char(Policy::decimal_point);
+  end[1] = '0';
+  return end + (end == point) * 2;
+}
+
+// Writes infinity or NaN to `buffer` pointing past the sign.
+template <typename Policy>
+ZMIJ_INLINE auto write_non_finite(char* buffer, bool negative, bool nan) noexcept
+    -> char* {
+  constexpr bool default_strings =
+      equal(Policy::inf(), "inf") && equal(Policy::neg_inf(), "-inf") &&
+      equal(Policy::nan(), "nan") && equal(Policy::neg_nan(), "-nan");
+  if (default_strings) {
+    memcpy(buffer, nan ? "nan" : "inf", 4);
+    return buffer + 3;
+  }
+  const char* s = nan ? (negative ? Policy::neg_nan() : Policy::nan())
+                      : (negative ? Policy::neg_inf() : Policy::inf());
+  buffer -= negative;
+  size_t len = strlen(s);
+  memcpy(buffer, s, len);
+  return buffer + len;
+}
 
 #if ZMIJ_USE_NEON  // An optimized version for NEON by Dougall Johnson.
 
@@ -899,7 +1223,7 @@ struct bcd_result {
   int len;
 };
 
-auto to_bcd8(uint64_t abcdefgh) noexcept -> bcd_result {
+inline auto to_bcd8(uint64_t abcdefgh) noexcept -> bcd_result {
   if (!ZMIJ_USE_SSE && !ZMIJ_USE_NEON) {
     // An optimization from Xiang JunBo.
     // Three steps BCD. Base 10000 -> base 100 -> base 10.
@@ -920,7 +1244,7 @@ auto to_bcd8(uint64_t abcdefgh) noexcept -> bcd_result {
     return {bcd, count_trailing_nonzeros(bcd)};
   }
 
-  const auto* d = &static_data;
+  const auto* d = &static_data::value;
   ZMIJ_ASM(("" : "+r"(d)));  // Load constants from memory.
 
 #if ZMIJ_USE_NEON
@@ -1125,6 +1449,98 @@ ZMIJ_INLINE auto write_exp_float_simd(char*, const dec_digits<64>&, int, bool,
   return nullptr;
 }
 
+// Writes a double in exponential notation with the significand and point
+// assembled by one shuffle instead of shifting the leading digit in memory.
+// exp_data is an exponent string table entry.
+ZMIJ_INLINE auto write_exp_double_simd(char* buffer, const dec_digits<64>& dig,
+                                       int last_digit, bool has_last_digit,
+                                       bool has_extra_digit, uint64_t exp_data,
+                                       char decimal_point,
+                                       const data& d) noexcept -> char* {
+  [[ZMIJ_MAYBE_UNUSED]] const unsigned char* shuffle =
+      d.exp_double_shuffles.data[has_extra_digit];
+#if ZMIJ_USE_SSE4_1
+  __m128i out = _mm_shuffle_epi8(dig.digits, _mm_load_si128(m128ptr(shuffle)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), out);
+  // The point pushes BCD[15] out of the vector if there is an extra digit.
+  buffer[16] = char(_mm_extract_epi8(dig.digits, 15));
+#elif ZMIJ_USE_NEON
+  uint8x16_t digits = vreinterpretq_u8_u16(dig.digits);
+  vst1q_u8(reinterpret_cast<uint8_t*>(buffer),
+           vqtbl1q_u8(digits, vld1q_u8(shuffle)));
+  buffer[16] = char(vgetq_lane_u8(digits, 15));
+#endif
+  buffer[1] = decimal_point;
+  buffer[16 + has_extra_digit] = char('0' + last_digit);
+  int len = has_extra_digit + select(has_last_digit, 17, dig.num_digits);
+  buffer += len - (len == 2);  // Remove trailing point.
+  int exp_len = int(exp_data >> 48);
+  if (is_big_endian) exp_data = bswap64(exp_data);
+  memcpy(buffer, &exp_data, 8);
+  return buffer + exp_len;
+}
+
+ZMIJ_INLINE auto write_exp_double_simd(char*, const dec_digits<32>&, int, bool,
+                                       bool, uint64_t, char,
+                                       const data&) noexcept -> char* {
+  return nullptr;
+}
+
+// Writes a number in fixed notation with the punctuation of Policy to `start`
+// pointing past the sign. `last_index` is the number of significant digits
+// minus one.
+template <typename Policy, int bcd_size, typename Digits>
+ZMIJ_INLINE auto write_fixed_punct(char*, const Digits&, char, bool, int, int,
+                                   std::false_type) noexcept -> char* {
+  return nullptr;
+}
+
+template <typename Policy, int bcd_size, typename Digits>
+ZMIJ_INLINE auto write_fixed_punct(char* start, const Digits& digits,
+                                   char last_digit, bool has_extra_digit,
+                                   int last_index, int dec_exp,
+                                   std::true_type) noexcept -> char* {
+  using table = punct_layout_table_for<Policy, bcd_size>;
+  static_assert(!Policy::point_zero ||
+                    table::prefix_size(Policy::min_fixed_exp) +
+                            float_traits<double>::max_digits10 <
+                        table::size,
+                "\".0\" must fit in double_buffer_size");
+  const auto& layout =
+      policy_punct_layouts<Policy, bcd_size>::value.get(dec_exp);
+  const unsigned char* shuffle = layout.shuffle[has_extra_digit];
+#if ZMIJ_USE_SSE4_1 || ZMIJ_USE_NEON
+  alignas(16) unsigned char bcd[16] = {};
+  memcpy(bcd, &digits, bcd_size);
+#  if ZMIJ_USE_SSE4_1
+  __m128i src = _mm_load_si128(m128ptr(bcd));
+  for (int i = 0; i < table::size; i += 16) {
+    __m128i out = _mm_or_si128(
+        _mm_shuffle_epi8(src, _mm_load_si128(m128ptr(shuffle + i))),
+        _mm_load_si128(m128ptr(layout.punct + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(start + i), out);
+  }
+#  else
+  uint8x16_t src = vld1q_u8(bcd);
+  for (int i = 0; i < table::size; i += 16) {
+    uint8x16_t out =
+        vorrq_u8(vqtbl1q_u8(src, vld1q_u8(shuffle + i)),
+                 vld1q_u8(reinterpret_cast<const uint8_t*>(layout.punct + i)));
+    vst1q_u8(reinterpret_cast<uint8_t*>(start + i), out);
+  }
+#  endif
+#else
+  // Without a byte shuffle, e.g. on SSE2, fill the bytes one at a time.
+  char bcd[bcd_size];
+  memcpy(bcd, &digits, bcd_size);
+  for (int i = 0; i < table::size; ++i)
+    start[i] = shuffle[i] < bcd_size ? bcd[shuffle[i]] : layout.punct[i];
+#endif
+  start[layout.last_digit_pos[has_extra_digit]] = last_digit;
+  return write_point_zero<Policy>(start + layout.end_pos[last_index],
+                                  start + layout.point_pos);
+}
+
 struct to_decimal_result {
   long long sig;
   int exp;
@@ -1239,11 +1655,71 @@ ZMIJ_INLINE auto to_decimal(UInt bin_sig, int64_t raw_exp, bool regular,
   return {integral, dec_exp, digit, (round_up + round_down) == 0};
 }
 
-}  // namespace
+// Writes the 16 hexadecimal digits of x, most significant first, to buffer.
+inline void write_hex_digits(char* buffer, uint64_t x) noexcept {
+#if ZMIJ_USE_NEON || ZMIJ_USE_SSE4_1
+  alignas(16) static const unsigned char hex_digits[] = {
+      '0', '1', '2', '3', '4', '5', '6', '7',
+      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+  x = is_big_endian ? x : bswap64(x);
+#endif
+#if ZMIJ_USE_NEON
+  uint8x8_t bytes = vcreate_u8(x);
+  uint8x8x2_t nibbles =
+      vzip_u8(vshr_n_u8(bytes, 4), vand_u8(bytes, vdup_n_u8(0x0f)));
+  uint8x16_t out = vqtbl1q_u8(vld1q_u8(hex_digits),
+                              vcombine_u8(nibbles.val[0], nibbles.val[1]));
+  vst1q_u8(reinterpret_cast<uint8_t*>(buffer), out);
+#elif ZMIJ_USE_SSE4_1
+  __m128i bytes = _mm_set_epi64x(0, int64_t(x));
+  __m128i mask = _mm_set1_epi8(0x0f);
+  __m128i nibbles =
+      _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask),
+                        _mm_and_si128(bytes, mask));
+  __m128i table =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(hex_digits));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer),
+                   _mm_shuffle_epi8(table, nibbles));
+#else
+  // Spread 8 nibbles into the low halves of 8 bytes, most significant first
+  // in a big-endian word, and convert them to ASCII without a lookup:
+  // ((n + 6) >> 4) is 1 for n in [10, 16) so it selects the 'a'-'9'-1 gap.
+  auto to_hex8 = [](uint64_t n) noexcept {
+    n = (n | n << 16) & 0x0000ffff0000ffff;
+    n = (n | n << 8) & 0x00ff00ff00ff00ff;
+    n = (n | n << 4) & 0x0f0f0f0f0f0f0f0f;
+    uint64_t letters = ((n + 0x0606060606060606) >> 4) & 0x0101010101010101;
+    n += zeros + letters * ('a' - '9' - 1);
+    return is_big_endian ? n : bswap64(n);
+  };
+  uint64_t hi = to_hex8(x >> 32), lo = to_hex8(x & 0xffffffff);
+  memcpy(buffer, &hi, 8);
+  memcpy(buffer + 8, &lo, 8);
+#endif
+}
+
+// Scales the decimal representation of a subnormal so that the significand
+// including the last digit has at least num_digits digits like for normals.
+// Uses a digit count and one multiplication instead of a loop because the
+// number of digits of subnormals varies widely.
+template <int num_digits>
+ZMIJ_INLINE auto normalize_subnormal(const to_decimal_result& dec) noexcept
+    -> to_decimal_result {
+  long long dec_sig = dec.sig * 10 + (-dec.has_last_digit & dec.last_digit);
+  int scale = num_digits - count_digits(uint64_t(dec_sig));
+  scale = scale > 0 ? scale : 0;
+  dec_sig *= pow10_tables<>::pow10s[scale];
+  long long q = ::div10(dec_sig);
+  int last_digit = int(dec_sig - q * 10);
+  return {q, dec.exp - scale, last_digit, last_digit != 0};
+}
+
+}  // namespace zmij_detail
 
 namespace zmij {
 
-inline auto to_decimal(double value) noexcept -> dec_fp {
+namespace detail {
+ZMIJ_INLINE auto do_to_decimal(double value) noexcept -> dec_fp {
   using traits = float_traits<double>;
   auto bits = traits::to_bits(value);
   auto bin_exp = traits::get_exp(bits);  // binary exponent
@@ -1256,15 +1732,52 @@ inline auto to_decimal(double value) noexcept -> dec_fp {
     bin_sig |= traits::implicit_bit;
   }
   auto dec = ::to_decimal<double>(bin_sig ^ traits::implicit_bit, bin_exp,
-                                  bin_sig != 0, static_data);
+                                  bin_sig != 0, static_data::value);
   auto last_digit = -dec.has_last_digit & dec.last_digit;
   return {dec.sig * 10 + last_digit, dec.exp, negative};
 }
+}  // namespace detail
+
+#if ZMIJ_POLICIES
+#  if ZMIJ_ENABLE_STATS
+namespace detail {
+auto thread_stats() noexcept -> conversion_stats&;
+}  // namespace detail
+#  endif
+#else
+ZMIJ_FUNC auto to_decimal(double value) noexcept -> dec_fp {
+  // Precision 0 denotes the shortest representation.
+  ZMIJ_PROBE(to_decimal_entry, float_traits<double>::to_bits(value), 0);
+  dec_fp dec = detail::do_to_decimal(value);
+  ZMIJ_PROBE(to_decimal_return, dec.sig, dec.exp);
+  return dec;
+}
+
+ZMIJ_FUNC void to_decimal(const double* values, size_t count,
+                          dec_fp* results) noexcept {
+  for (size_t i = 0; i < count; ++i)
+    results[i] = detail::do_to_decimal(values[i]);
+}
+
+#  if ZMIJ_ENABLE_STATS
+namespace detail {
+// A function rather than a variable so the header-only mode has one instance.
+ZMIJ_FUNC auto thread_stats() noexcept -> conversion_stats& {
+  static thread_local conversion_stats stats = {};
+  return stats;
+}
+}  // namespace detail
+
+ZMIJ_FUNC auto stats() noexcept -> conversion_stats {
+  return detail::thread_stats();
+}
+#  endif
+#endif  // ZMIJ_POLICIES
 
 namespace detail {
 
 template <typename Float>
-auto to_decimal(Float value, int precision) noexcept -> dec_fp {
+ZMIJ_INLINE auto do_to_decimal(Float value, int precision) noexcept -> dec_fp {
   assert(precision >= 1 && precision <= 18);
   using traits = float_traits<Float>;
   auto bits = traits::to_bits(value);
@@ -1292,23 +1805,42 @@ auto to_decimal(Float value, int precision) noexcept -> dec_fp {
   // so one round-half-to-even step rounds it (idea by Russ Cox).
   constexpr int shift = 64 - traits::digits;  // Left-justify the significand.
   int point_shift = shift - compute_exp_shift(bin_exp, dec_exp);
-  uint128 pow10 = static_data.pow10_significands[-dec_exp];
-  // Bump inexact powers (dec_exp < -55 or > 0) up to a 128-bit ceiling so they
-  // can't mimic an exact tie; the +1 stays in the low word, never carrying.
-  uint128 p = umul192_hi128(pow10.hi, pow10.lo + (dec_exp < -55 | dec_exp > 0),
-                            uint64_t(bin_sig) << shift);
+  uint128 pow10 = static_data::value.pow10_significands[-dec_exp];
+  uint64_t tail_mask = (uint64_t(1) << (point_shift - 1)) - 1;
+  uint128 p = {};
+  bool use_pow10_hi = traits::num_bits == 32;
+  if (use_pow10_hi) {
+    // A float significand has only 24 bits so a single 64x64 multiply by the
+    // upper half of the power suffices. It is exact for dec_exp in [-27, 0]
+    // (5**27 < 2**64); otherwise the power is bumped to a 64-bit ceiling which
+    // overestimates the product by less than one unit of p.hi. Then p.hi is
+    // conclusive unless its bits below 1/2 are zero, so fall back to the
+    // 128-bit power in that rare case which also covers exact ties.
+    bool exact = dec_exp >= -27 && dec_exp <= 0;
+    auto p64 = umul128(pow10.hi + !exact, uint64_t(bin_sig) << shift);
+    p = {uint64_t(p64 >> 64), exact ? uint64_t(p64) : 0};
+    use_pow10_hi = exact || (p.hi & tail_mask) != 0;
+  }
+  if (!use_pow10_hi) {
+    // Bump inexact powers (dec_exp < -55 or > 0) up to a 128-bit ceiling so
+    // they can't mimic an exact tie; the +1 stays in the low word, never
+    // carrying.
+    p = umul192_hi128(pow10.hi, pow10.lo + (dec_exp < -55 | dec_exp > 0),
+                      uint64_t(bin_sig) << shift);
+  }
 
   uint64_t integral = p.hi >> point_shift;
   // The ceiling makes the low 64 product bits unreliable, so sticky uses only
   // p.lo and p.hi's bits below 1/2; inexact powers always leave a 1 there.
   uint64_t half = p.hi >> (point_shift - 1) & 1;
-  uint64_t tail = (p.hi & ((uint64_t(1) << (point_shift - 1)) - 1)) | p.lo;
+  uint64_t tail = (p.hi & tail_mask) | p.lo;
   uint64_t scaled = integral << 2 | half << 1 | (tail != 0);
 
   // Round half-to-even off the two guard bits.
   auto round_even = [](uint64_t x) { return (x + 1 + ((x >> 2) & 1)) >> 2; };
   long long dec_sig = round_even(scaled);
-  if (dec_sig >= pow10s[precision]) {  // One digit too many (overshoot/carry).
+  // One digit too many (overshoot/carry).
+  if (dec_sig >= pow10_tables<>::pow10s[precision]) {
     // Drop one decimal digit and round again, preserving the sticky bit.
     dec_sig = round_even(scaled / 10 | (scaled & 1) | (scaled % 10 != 0));
     ++dec_exp;
@@ -1316,69 +1848,93 @@ auto to_decimal(Float value, int precision) noexcept -> dec_fp {
   return {dec_sig, dec_exp, negative};
 }
 
-// It is slightly faster to return a pointer to the end than the size.
 template <typename Float>
-auto write(Float value, char* buffer) noexcept -> char* {
-  using traits = float_traits<Float>;
-  auto bits = traits::to_bits(value);
-  // It is beneficial to extract exponent and significand early.
-  auto bin_exp = traits::get_exp(bits);  // binary exponent
-  auto bin_sig = traits::get_sig(bits);  // binary significand
+auto to_decimal(Float value, int precision) noexcept -> dec_fp {
+  ZMIJ_PROBE(to_decimal_entry, float_traits<Float>::to_bits(value), precision);
+  dec_fp dec = do_to_decimal(value, precision);
+  ZMIJ_PROBE(to_decimal_return, dec.sig, dec.exp);
+  return dec;
+}
 
-  *buffer = '-';
-  buffer += traits::is_negative(bits);
+// A field of `width` characters with the output aligned in it and the rest
+// filled with `fill`.
+struct padding {
+  size_t width;
+  char fill;
+  align alignment;
+};
 
-  const auto* d = &static_data;
-  ZMIJ_ASM(("" : "+r"(d)));  // Load constants from memory.
-  uint64_t threshold = traits::num_bits == 64 ? d->threshold : uint64_t(1e7);
+// Fills the padding before `size` characters aligned in the field starting at
+// `out` and returns the start of the output.
+ZMIJ_INLINE auto pad_left(char* out, size_t size, const padding& pad) noexcept
+    -> char* {
+  if (size >= pad.width || pad.alignment == align::left) return out;
+  size_t n = pad.width - size;
+  if (pad.alignment == align::center) n /= 2;
+  memset(out, pad.fill, n);
+  return out + n;
+}
 
-  to_decimal_result dec;
-  bool is_normal = unsigned(bin_exp - 1) < unsigned(traits::exp_mask - 1);
-  if (!is_normal) [[ZMIJ_UNLIKELY]] {
-    if (bin_exp != 0) {
-      memcpy(buffer, bin_sig == 0 ? "inf" : "nan", 4);
-      return buffer + 3;
-    }
-    if (bin_sig == 0) {
-      memcpy(buffer, "0", 2);
-      return buffer + 1;
-    }
-    dec = ::to_decimal<Float>(bin_sig, 1, true, *d);
-    long long dec_sig = dec.sig * 10 + (-dec.has_last_digit & dec.last_digit);
-    int dec_exp = dec.exp;
-    while (dec_sig < threshold) {
-      dec_sig *= 10;
-      --dec_exp;
-    }
-    long long q = ::div10(dec_sig);
-    int last_digit = dec_sig - q * 10;
-    dec = {q, dec_exp, last_digit, last_digit != 0};
-  } else {
-    dec = ::to_decimal<Float>(bin_sig | traits::implicit_bit, bin_exp,
-                              bin_sig != 0, *d);
-  }
-  bool has_last_digit = dec.has_last_digit;
-  bool has_extra_digit = dec.sig >= threshold;
-  int dec_exp = dec.exp + traits::max_digits10 - 2 + has_extra_digit;
-  if (traits::num_bits == 32 && dec.sig < uint32_t(1e6)) [[ZMIJ_UNLIKELY]] {
-    dec.sig = 10 * dec.sig + (-has_last_digit & dec.last_digit);
-    has_last_digit = false;
-    --dec_exp;
+// Returns the size of the output for a finite nonzero value with num_digits
+// significant digits and the decimal exponent dec_exp excluding the sign.
+template <typename Policy>
+ZMIJ_INLINE auto output_size(int dec_exp, int num_digits, const data& d) noexcept
+    -> int {
+  if (dec_exp >= Policy::min_fixed_exp && dec_exp <= Policy::max_fixed_exp) {
+    const auto& layout = get_fixed_layouts<Policy>(d)->get(dec_exp);
+    int size = layout.start_pos + layout.end_pos[num_digits - 1];
+    if (Policy::point_zero) size += (size == layout.point_pos) * 2;
+    if (Policy::group_separator != 0 && dec_exp > 0)
+      size += dec_exp / Policy::group_size;
+    return size;
   }
+  int abs_exp = dec_exp >= 0 ? dec_exp : -dec_exp;
+  return num_digits + (num_digits > 1) + 2 +
+         (Policy::exp_plus || dec_exp < 0) +
+         (abs_exp >= 10 || Policy::min_exp_digits == 2) + (abs_exp >= 100);
+}
 
-  // Write significand/fixed.
-  char* start = buffer;
-  auto dig = to_digits<traits::num_bits>(dec.sig, *d);
+// Writes a decimal number with the significand digits dig, the last digit
+// dec.last_digit if has_last_digit is set and the exponent of the leading
+// digit dec_exp in the notation selected by Policy to buffer pointing past
+// the sign.
+template <typename Float, typename Policy, typename Digits>
+ZMIJ_INLINE auto write_decimal(char* buffer, const Digits& dig,
+                               const to_decimal_result& dec,
+                               bool has_last_digit, bool has_extra_digit,
+                               int dec_exp, const data* d) noexcept -> char* {
+  using traits = float_traits<Float>;
   constexpr int bcd_size = traits::num_bits == 64 ? 16 : 8;
-  if (dec_exp >= traits::min_fixed_dec_exp &&
-      dec_exp <= traits::max_fixed_dec_exp) {
+  char* start = buffer;
+  if (dec_exp >= Policy::min_fixed_exp && dec_exp <= Policy::max_fixed_exp) {
+    ZMIJ_COUNT(fixed);
+    constexpr bool has_punct =
+        Policy::decimal_point != '.' || Policy::group_separator != 0;
+    if (has_punct) {
+      int num_digits = select(has_last_digit, bcd_size, dig.num_digits - 1);
+      return write_fixed_punct<Policy, bcd_size>(
+          start, dig.digits, '0' + (-has_last_digit & dec.last_digit),
+          has_extra_digit, num_digits + has_extra_digit - 1, dec_exp,
+          std::integral_constant<bool, has_punct>());
+    }
     memcpy(start, &zeros, 8);  // For dec_exp < 0.
+    if (Policy::min_fixed_exp < -7) memcpy(start + 8, &zeros, 8);
     char last_digit = '0' + (-has_last_digit & dec.last_digit);
     int num_digits = select(has_last_digit, bcd_size, dig.num_digits - 1);
 
+    // Integers with more digits than the significand have no point: write
+    // the digits over enough zeros for the largest exponent (< 32).
+    if (Policy::max_fixed_exp >= bcd_size && dec_exp >= bcd_size) {
+      for (int i = bcd_size; i < 32; i += 8) memcpy(buffer + i, &zeros, 8);
+      write_digits(buffer, dig.digits, !has_extra_digit, *d);
+      buffer[bcd_size + has_extra_digit - 1] = last_digit;
+      buffer += dec_exp + 1;
+      return write_point_zero<Policy>(buffer, buffer);
+    }
+
     // Materialize the base early so the entry address is `base + idx*32`;
     // otherwise Clang folds the offset in and adds a cycle to the idx chain.
-    const auto* fixed_layouts = &d->fixed_layouts;
+    const auto* fixed_layouts = get_fixed_layouts<Policy>(*d);
     if (ZMIJ_AARCH64) ZMIJ_ASM(("" : "+r"(fixed_layouts)));
 
     const auto& layout = fixed_layouts->get(dec_exp);
@@ -1394,7 +1950,9 @@ auto write(Float value, char* buffer) noexcept -> char* {
       buffer[bcd_size] = char(_mm_extract_epi8(digits, 15));
       start[layout.point_pos] = '.';
       buffer[layout.last_digit_pos[has_extra_digit]] = last_digit;
-      return buffer + layout.end_pos[num_digits + has_extra_digit - 1];
+      return write_point_zero<Policy>(
+          buffer + layout.end_pos[num_digits + has_extra_digit - 1],
+          start + layout.point_pos);
     }
 #endif  // ZMIJ_USE_SSE4_1
     write_digits(buffer, dig.digits, !has_extra_digit, *d);
@@ -1402,25 +1960,39 @@ auto write(Float value, char* buffer) noexcept -> char* {
     unsigned point_pos = layout.point_pos;
     memmove(start + layout.shift_pos, start + point_pos, bcd_size);
     start[point_pos] = '.';
-    return buffer + layout.end_pos[num_digits + has_extra_digit - 1];
+    return write_point_zero<Policy>(
+        buffer + layout.end_pos[num_digits + has_extra_digit - 1],
+        start + point_pos);
   }
-  if (traits::num_bits == 32 && exp_float_shuffle_table::enable) {
+  ZMIJ_COUNT(exponential);
+  if (traits::num_bits == 32 && exp_float_shuffle_table::enable &&
+      Policy::min_exp_digits == 2 && Policy::exp_plus &&
+      Policy::decimal_point == '.') {
     uint64_t exp_data = d->exp_strings.data[dec_exp + exp_string_table::offset];
     return write_exp_float_simd(buffer, dig, dec.last_digit, has_last_digit,
                                 has_extra_digit, exp_data, *d);
   }
 
+  if (traits::num_bits == 64 && exp_double_shuffle_table::enable) {
+    const auto* exp_strings = get_exp_strings<Policy>(*d);
+    uint64_t exp_data = exp_strings->data[dec_exp + exp_string_table::offset];
+    return write_exp_double_simd(buffer, dig, dec.last_digit, has_last_digit,
+                                 has_extra_digit, exp_data,
+                                 char(Policy::decimal_point), *d);
+  }
+
   buffer += has_extra_digit;
   memcpy(buffer, &dig.digits, bcd_size);
   buffer[bcd_size] = '0' + dec.last_digit;
   buffer += select(has_last_digit, bcd_size + 1, dig.num_digits);
   start[0] = start[1];
-  start[1] = '.';
+  start[1] = char(Policy::decimal_point);
   buffer -= (buffer - 1 == start + 1);  // Remove trailing point.
 
   // Write exponent.
   if (exp_string_table::enable) {
-    uint64_t exp_data = d->exp_strings.data[dec_exp + exp_string_table::offset];
+    const auto* exp_strings = get_exp_strings<Policy>(*d);
+    uint64_t exp_data = exp_strings->data[dec_exp + exp_string_table::offset];
     int len = int(exp_data >> 48);
     if (is_big_endian) exp_data = bswap64(exp_data);
     memcpy(buffer, &exp_data, traits::max_exponent10 >= 100 ? 8 : 4);
@@ -1429,8 +2001,12 @@ auto write(Float value, char* buffer) noexcept -> char* {
   uint16_t e_sign = dec_exp >= 0 ? ('+' << 8 | 'e') : ('-' << 8 | 'e');
   if (is_big_endian) e_sign = e_sign << 8 | e_sign >> 8;
   memcpy(buffer, &e_sign, 2);
-  buffer += 2;
+  buffer += Policy::exp_plus ? 2 : 1 + (dec_exp < 0);
   dec_exp = dec_exp >= 0 ? dec_exp : -dec_exp;
+  if (Policy::min_exp_digits == 1 && dec_exp < 10) {
+    *buffer = char('0' + dec_exp);
+    return buffer + 1;
+  }
   if (traits::max_exponent10 >= 100) {
     // digit = dec_exp / 100
     uint32_t digit = use_umul128_hi64
@@ -1444,11 +2020,298 @@ auto write(Float value, char* buffer) noexcept -> char* {
   return buffer + 2;
 }
 
+// It is slightly faster to return a pointer to the end than the size.
+// If the shortest representation has more than max_digits significant digits,
+// the value is rounded to max_digits instead. Policy selects the notation (see
+// default_policy). If pad is not null, the output of a finite nonzero value is
+// aligned in the field and the padding before it is filled.
+template <typename Float, typename Policy>
+ZMIJ_INLINE auto do_write(Float value, char* buffer, int max_digits,
+                          const padding* pad = nullptr) noexcept -> char* {
+  static_assert(!Policy::point_zero || (Policy::min_fixed_exp >= -13 &&
+                                        Policy::max_fixed_exp <= 29),
+                "\".0\" must fit in double_buffer_size");
+  using traits = float_traits<Float>;
+  auto bits = traits::to_bits(value);
+  // It is beneficial to extract exponent and significand early.
+  auto bin_exp = traits::get_exp(bits);  // binary exponent
+  auto bin_sig = traits::get_sig(bits);  // binary significand
+
+  *buffer = '-';
+  buffer += traits::is_negative(bits);
+
+  const auto* d = &static_data::value;
+  ZMIJ_ASM(("" : "+r"(d)));  // Load constants from memory.
+  uint64_t threshold = traits::num_bits == 64 ? d->threshold : uint64_t(1e7);
+  ZMIJ_COUNT(writes);
+
+  to_decimal_result dec;
+  bool is_normal = unsigned(bin_exp - 1) < unsigned(traits::exp_mask - 1);
+  if (!is_normal) [[ZMIJ_UNLIKELY]] {
+    if (bin_exp != 0) {
+      ZMIJ_COUNT(non_finite);
+      return write_non_finite<Policy>(buffer, traits::is_negative(bits),
+                                      bin_sig != 0);
+    }
+    if (bin_sig == 0) {
+      ZMIJ_COUNT(zero);
+      if (!Policy::signed_zero) buffer -= traits::is_negative(bits);
+      if (Policy::point_zero) {
+        memcpy(buffer, "0.0", 4);
+        buffer[1] = char(Policy::decimal_point);
+        return buffer + 3;
+      }
+      memcpy(buffer, "0", 2);
+      return buffer + 1;
+    }
+    ZMIJ_COUNT(subnormal);
+    // Scale to threshold (10**15 or 10**7) or above: 16 or 8 digits.
+    dec = normalize_subnormal<traits::num_bits == 64 ? 16 : 8>(
+        ::to_decimal<Float>(bin_sig, 1, true, *d));
+  } else {
+    if (bin_sig == 0) ZMIJ_COUNT(irregular);
+    dec = ::to_decimal<Float>(bin_sig | traits::implicit_bit, bin_exp,
+                              bin_sig != 0, *d);
+  }
+  bool has_last_digit = dec.has_last_digit;
+  bool has_extra_digit = dec.sig >= threshold;
+  int dec_exp = dec.exp + traits::max_digits10 - 2 + has_extra_digit;
+  if (has_extra_digit) ZMIJ_COUNT(extra_digit);
+  if (traits::num_bits == 32 && dec.sig < uint32_t(1e6)) [[ZMIJ_UNLIKELY]] {
+    ZMIJ_COUNT(short_float);
+    dec.sig = 10 * dec.sig + (-has_last_digit & dec.last_digit);
+    has_last_digit = false;
+    --dec_exp;
+  }
+  if (has_last_digit) ZMIJ_COUNT(last_digit);
+
+  // The significand including the last digit has max_digits10 - 1 digits plus
+  // the extra one. Drop the digits past max_digits if any of them is nonzero.
+  int num_dropped = traits::max_digits10 - 1 + has_extra_digit - max_digits;
+  if (max_digits < traits::max_digits10 && num_dropped > 0) {
+    const long long* pow10s = pow10_tables<>::pow10s;
+    long long dec_sig = dec.sig * 10 + (-has_last_digit & dec.last_digit);
+    long long unit = pow10s[num_dropped];
+    long long q = dec_sig / unit;
+    long long r = dec_sig - q * unit;
+    if (r == unit / 2) [[ZMIJ_UNLIKELY]] {
+      // A tie of the shortest digits doesn't tell on which side of it the
+      // exact value is, so round the exact value. Elsewhere rounding the
+      // shortest digits can't round twice: a decimal between them and the
+      // exact value with max_digits + 1 digits would be shorter.
+      dec_fp rounded = do_to_decimal(value, max_digits);
+      int scale = traits::max_digits10 - 1 - max_digits;
+      dec_sig = rounded.sig * pow10s[scale];
+      q = ::div10(dec_sig);
+      int last_digit = int(dec_sig - q * 10);
+      dec = {q, rounded.exp - scale, last_digit, last_digit != 0};
+      has_last_digit = dec.has_last_digit;
+      has_extra_digit = uint64_t(dec.sig) >= threshold;
+      dec_exp = dec.exp + traits::max_digits10 - 2 + has_extra_digit;
+    } else if (r != 0) {
+      q += r > unit / 2;
+      if (q == pow10s[max_digits]) {  // Carry, e.g. 9.99 to 10.0.
+        q = pow10s[max_digits - 1];
+        ++dec.exp;
+        ++dec_exp;
+      }
+      // Keep the number of digits so has_extra_digit stays valid.
+      dec.sig = q * pow10s[num_dropped - 1];
+      has_last_digit = false;
+    }
+  }
+
+  // Write significand/fixed.
+  char* start = buffer;
+  auto dig = to_digits<traits::num_bits>(dec.sig, *d);
+  constexpr int bcd_size = traits::num_bits == 64 ? 16 : 8;
+  if (pad) {
+    // Write the output in its final position rather than moving it.
+    bool negative = traits::is_negative(bits);
+    int num_digits = select(has_last_digit, bcd_size, dig.num_digits - 1);
+    int size = negative + output_size<Policy>(
+                              dec_exp, num_digits + has_extra_digit, *d);
+    char* out = pad_left(start - negative, size, *pad);
+    *out = '-';
+    start = buffer = out + negative;
+  }
+  return write_decimal<Float, Policy>(start, dig, dec, has_last_digit,
+                                     has_extra_digit, dec_exp, d);
+}
+
+#if !ZMIJ_POLICIES
+// Writes value in decimal as groups of 8 digits converted by to_bcd8 with the
+// leading zeros of the first group removed.
+ZMIJ_FUNC auto write_int(long long value, char* buffer) noexcept -> char* {
+  *buffer = '-';
+  buffer += value < 0;
+  uint64_t n = value < 0 ? 0 - uint64_t(value) : uint64_t(value);
+  constexpr uint64_t e8 = 100'000'000;
+  uint64_t groups[] = {n / (e8 * e8), n / e8 % e8, n % e8};
+  int first = n >= e8 * e8 ? 0 : n >= e8 ? 1 : 2;
+  uint64_t bcd = to_bcd8(groups[first]).bcd;
+  // Keep one digit for zero.
+  int num_zeros = bcd == 0 ? 7 : (is_big_endian ? clz(bcd) : ctz(bcd)) / 8;
+  bcd += zeros;
+  bcd = is_big_endian ? bcd << (num_zeros * 8) : bcd >> (num_zeros * 8);
+  memcpy(buffer, &bcd, 8);
+  buffer += 8 - num_zeros;
+  for (int i = first + 1; i < 3; ++i) {
+    bcd = to_bcd8(groups[i]).bcd + zeros;
+    memcpy(buffer, &bcd, 8);
+    buffer += 8;
+  }
+  return buffer;
+}
+#endif  // !ZMIJ_POLICIES
+
+template <typename Float>
+auto write(Float value, char* buffer) noexcept -> char* {
+  ZMIJ_PROBE(write_entry, float_traits<Float>::to_bits(value),
+             float_traits<Float>::num_bits);
+  using traits = float_traits<Float>;
+  char* end = do_write<Float, default_policy<Float>>(value, buffer,
+                                                     traits::max_digits10);
+  ZMIJ_PROBE(write_return, float_traits<Float>::to_bits(value), end - buffer);
+  return end;
+}
+
+template <typename Float>
+auto write_shortest_capped(Float value, int max_digits, char* buffer) noexcept
+    -> char* {
+  return do_write<Float, default_policy<Float>>(value, buffer, max_digits);
+}
+
+template <typename Policy, typename Float>
+auto basic_write(Float value, char* buffer) noexcept -> char* {
+  return do_write<Float, Policy>(value, buffer,
+                                 float_traits<Float>::max_digits10);
+}
+
+template <typename Float>
+auto write_padded(Float value, char* buffer, size_t width, char fill,
+                  align alignment) noexcept -> char* {
+  using traits = float_traits<Float>;
+  using policy = default_policy<Float>;
+  padding pad = {width, fill, alignment};
+  auto bits = traits::to_bits(value);
+  char* end = nullptr;
+  if (typename traits::sig_type(bits << 1) == 0 ||
+      traits::get_exp(bits) == traits::exp_mask) [[ZMIJ_UNLIKELY]] {
+    // Zeros and non-finite values are short and rare so move them instead.
+    char tmp[double_buffer_size];
+    size_t size =
+        do_write<Float, policy>(value, tmp, traits::max_digits10) - tmp;
+    char* start = pad_left(buffer, size, pad);
+    memcpy(start, tmp, size);
+    end = start + size;
+  } else {
+    end = do_write<Float, policy>(value, buffer, traits::max_digits10, &pad);
+  }
+  if (end >= buffer + width) return end;
+  memset(end, fill, buffer + width - end);
+  return buffer + width;
+}
+
+#if !ZMIJ_POLICIES
+// Writes value like printf's %a in glibc: normals as 0x1.<digits>p<exp> and
+// subnormals as 0x0.<digits>p-1022 with trailing zero digits removed.
+ZMIJ_FUNC auto write_hex(double value, char* buffer) noexcept -> char* {
+  using traits = float_traits<double>;
+  auto bits = traits::to_bits(value);
+  auto bin_sig = traits::get_sig(bits);
+  auto bin_exp = traits::get_exp(bits);
+
+  *buffer = '-';
+  buffer += traits::is_negative(bits);
+  if (bin_exp == traits::exp_mask) [[ZMIJ_UNLIKELY]] {
+    memcpy(buffer, bin_sig == 0 ? "inf" : "nan", 4);
+    return buffer + 3;
+  }
+
+  bool normal = bin_exp != 0;
+  memcpy(buffer, "0x0.", 4);
+  buffer[2] += normal;
+  // Left-align the significand so that its 13 nibbles come first.
+  write_hex_digits(buffer + 4, bin_sig << (traits::num_exp_bits + 1));
+  int num_digits = bin_sig != 0 ? 13 - ctz(bin_sig) / 4 : 0;
+  buffer += 3 + (num_digits != 0) + num_digits;
+
+  int exp = normal ? int(bin_exp) - traits::exp_bias
+                   : (bin_sig != 0) * (1 - traits::exp_bias);
+  buffer[0] = 'p';
+  buffer[1] = exp < 0 ? '-' : '+';
+  unsigned abs_exp = exp < 0 ? unsigned(-exp) : unsigned(exp);
+  buffer += 3 + (abs_exp >= 10) + (abs_exp >= 100) + (abs_exp >= 1000);
+  char* p = buffer;
+  do {
+    *--p = char('0' + abs_exp % 10);
+    abs_exp /= 10;
+  } while (abs_exp != 0);
+  return buffer;
+}
+#endif  // !ZMIJ_POLICIES
+
+#if ZMIJ_POLICIES
+template auto write_shortest_capped(float value, int max_digits,
+                                    char* buffer) noexcept -> char*;
+template auto write_shortest_capped(double value, int max_digits,
+                                    char* buffer) noexcept -> char*;
+
+template auto basic_write<js_notation>(float value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<js_notation>(double value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<exponential_notation>(float value,
+                                                char* buffer) noexcept -> char*;
+template auto basic_write<exponential_notation>(double value,
+                                                char* buffer) noexcept -> char*;
+template auto basic_write<js_policy>(float value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<js_policy>(double value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<python_policy>(float value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<python_policy>(double value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<rust_policy>(float value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<rust_policy>(double value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<go_policy>(float value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<go_policy>(double value, char* buffer) noexcept
+    -> char*;
+template auto basic_write<locale_policy<','>>(float value,
+                                              char* buffer) noexcept -> char*;
+template auto basic_write<locale_policy<','>>(double value,
+                                              char* buffer) noexcept -> char*;
+template auto basic_write<locale_policy<',', '.'>>(float value,
+                                                   char* buffer) noexcept
+    -> char*;
+template auto basic_write<locale_policy<',', '.'>>(double value,
+                                                   char* buffer) noexcept
+    -> char*;
+template auto basic_write<locale_policy<'.', ','>>(float value,
+                                                   char* buffer) noexcept
+    -> char*;
+template auto basic_write<locale_policy<'.', ','>>(double value,
+                                                   char* buffer) noexcept
+    -> char*;
+
+template auto write_padded(float value, char* buffer, size_t width, char fill,
+                           align alignment) noexcept -> char*;
+template auto write_padded(double value, char* buffer, size_t width, char fill,
+                           align alignment) noexcept -> char*;
+#elif !ZMIJ_HEADER_ONLY
 template auto write(float value, char* buffer) noexcept -> char*;
 template auto write(double value, char* buffer) noexcept -> char*;
 
 template auto to_decimal(float value, int precision) noexcept -> dec_fp;
 template auto to_decimal(double value, int precision) noexcept -> dec_fp;
+#endif
 
 }  // namespace detail
 }  // namespace zmij
+
+#endif  // ZMIJ_CC_
@@ -10,15 +10,43 @@
 #include <stddef.h>  // size_t
 #include <string.h>  // memcpy
 
+// Define ZMIJ_HEADER_ONLY=1 to compile the implementation into every
+// translation unit that includes this header, allowing detail::write to be
+// inlined into callers without LTO.
+#ifndef ZMIJ_HEADER_ONLY
+#  define ZMIJ_HEADER_ONLY 0
+#endif
+
+// Define ZMIJ_ENABLE_STATS=1 to count which conversion paths are taken.
+#ifndef ZMIJ_ENABLE_STATS
+#  define ZMIJ_ENABLE_STATS 0
+#endif
+
 namespace zmij {
 struct dec_fp;
 
+enum class align { left, center, right };
+
 namespace detail {
 template <typename Float>
 auto to_decimal(Float value, int precision) noexcept -> dec_fp;
 
 template <typename Float>
 auto write(Float value, char* buffer) noexcept -> char*;
+
+template <typename Float>
+auto write_shortest_capped(Float value, int max_digits, char* buffer) noexcept
+    -> char*;
+
+template <typename Policy, typename Float>
+auto basic_write(Float value, char* buffer) noexcept -> char*;
+
+auto write_hex(double value, char* buffer) noexcept -> char*;
+auto write_int(long long value, char* buffer) noexcept -> char*;
+
+template <typename Float>
+auto write_padded(Float value, char* buffer, size_t width, char fill,
+                  align alignment) noexcept -> char*;
 }  // namespace detail
 
 enum {
@@ -38,6 +66,11 @@ struct dec_fp {
 ///   auto [sig, exp, negative] = to_decimal(6.62607015e-34);
 auto to_decimal(double value) noexcept -> dec_fp;
 
+/// Converts `count` values from `values` like `to_decimal(double)` and stores
+/// the results to `results`. This has higher throughput than calling
+/// `to_decimal(double)` for each value because the conversion is inlined.
+void to_decimal(const double* values, size_t count, dec_fp* results) noexcept;
+
 /// Converts `value` into a correctly rounded decimal with exactly `precision`
 /// significant digits (sig * 10**exp). `precision` must be in [1, 18];
 /// out-of-range values are clamped.
@@ -61,6 +94,7 @@ inline auto to_decimal(double value, int precision) noexcept -> dec_fp {
 enum {
   float_buffer_size = 17,
   double_buffer_size = 34,
+  hex_buffer_size = 24,
 };
 
 /// Writes the shortest correctly rounded decimal representation of `value` to
@@ -89,6 +123,255 @@ inline auto write(char* out, size_t n, double value) noexcept -> char* {
   return out + size;
 }
 
+/// Writes `value` like `write` but if it is exactly representable as a float,
+/// writes the shortest representation that round-trips through a float, e.g.
+/// "0.1" rather than "0.10000000149011612" for `double(0.1f)`.
+inline auto write_as_float_if_exact(char* out, size_t n, double value) noexcept
+    -> char* {
+  // Check the range first because converting a double outside of it to float
+  // is undefined behavior. NaNs and infinities take the double path.
+  constexpr double max_float = 3.4028234663852886e+38;
+  if (value >= -max_float && value <= max_float) {
+    float f = float(value);
+    if (f == value) return write(out, n, f);
+  }
+  return write(out, n, value);
+}
+
+/// Writes `value` like `write` if its shortest representation has at most
+/// `max_digits` significant digits, otherwise writes `value` correctly rounded
+/// to `max_digits` significant digits. `max_digits` must be in [1, 9];
+/// out-of-range values are clamped. Defined in zmij-policies.
+inline auto write_shortest_capped(char* out, size_t n, float value,
+                                  int max_digits) noexcept -> char* {
+  assert(max_digits >= 1 && max_digits <= 9);
+  if (max_digits < 1) max_digits = 1;
+  if (max_digits > 9) max_digits = 9;
+  if (n >= float_buffer_size)
+    return detail::write_shortest_capped(value, max_digits, out);
+  char buffer[float_buffer_size];
+  size_t size =
+      detail::write_shortest_capped(value, max_digits, buffer) - buffer;
+  if (size > n) size = n;
+  memcpy(out, buffer, size);
+  return out + size;
+}
+
+/// Writes `value` like `write` if its shortest representation has at most
+/// `max_digits` significant digits, otherwise writes `value` correctly rounded
+/// to `max_digits` significant digits. `max_digits` must be in [1, 17];
+/// out-of-range values are clamped. Defined in zmij-policies.
+inline auto write_shortest_capped(char* out, size_t n, double value,
+                                  int max_digits) noexcept -> char* {
+  assert(max_digits >= 1 && max_digits <= 17);
+  if (max_digits < 1) max_digits = 1;
+  if (max_digits > 17) max_digits = 17;
+  if (n >= double_buffer_size)
+    return detail::write_shortest_capped(value, max_digits, out);
+  char buffer[double_buffer_size];
+  size_t size =
+      detail::write_shortest_capped(value, max_digits, buffer) - buffer;
+  if (size > n) size = n;
+  memcpy(out, buffer, size);
+  return out + size;
+}
+
+/// An output policy for `basic_write`: finite nonzero values with the decimal
+/// exponent (of the leading digit) in [MinFixedExp, MaxFixedExp] are written in
+/// fixed notation and others in exponential notation. The layout tables for
+/// the range are generated at compile time. Other aspects of the output can be
+/// changed by deriving from it and redefining the members.
+template <int MinFixedExp, int MaxFixedExp> struct write_policy {
+  static_assert(MinFixedExp >= -15 && MaxFixedExp <= 31,
+                "fixed notation must fit in double_buffer_size");
+  enum {
+    min_fixed_exp = MinFixedExp,
+    max_fixed_exp = MaxFixedExp,
+    min_exp_digits = 2,  // Exponents are padded with zeros to 1 or 2 digits.
+    exp_plus = 1,        // Whether nonnegative exponents have a '+' sign.
+    signed_zero = 1,     // Whether negative zero is written as "-0".
+    point_zero = 0,      // Whether integers in fixed notation end with ".0".
+    decimal_point = '.',
+    group_separator = 0,  // Separates groups of integer digits if nonzero.
+    group_size = 3,       // The number of digits in a group.
+  };
+  // Strings for infinities and NaNs including the sign.
+  static constexpr auto inf() noexcept -> const char* { return "inf"; }
+  static constexpr auto neg_inf() noexcept -> const char* { return "-inf"; }
+  static constexpr auto nan() noexcept -> const char* { return "nan"; }
+  static constexpr auto neg_nan() noexcept -> const char* { return "-nan"; }
+};
+
+/// Fixed notation for magnitudes in [1e-6, 1e21) as in JavaScript.
+using js_notation = write_policy<-6, 20>;
+
+/// Exponential notation for all finite nonzero values.
+using exponential_notation = write_policy<1, 0>;
+
+/// The output of JavaScript's Number.prototype.toString: fixed notation for
+/// magnitudes in [1e-6, 1e21), exponents without padding such as "1e+21",
+/// "0" for negative zero, "NaN" and "Infinity".
+struct js_policy : write_policy<-6, 20> {
+  enum { min_exp_digits = 1, signed_zero = 0 };
+  static constexpr auto inf() noexcept -> const char* { return "Infinity"; }
+  static constexpr auto neg_inf() noexcept -> const char* {
+    return "-Infinity";
+  }
+  static constexpr auto nan() noexcept -> const char* { return "NaN"; }
+  static constexpr auto neg_nan() noexcept -> const char* { return "NaN"; }
+};
+
+/// The output of Python's repr: fixed notation for magnitudes in [1e-4, 1e16)
+/// with ".0" after integers such as "100.0", exponents such as "1e+16" and
+/// "nan" regardless of the sign.
+struct python_policy : write_policy<-4, 15> {
+  enum { point_zero = 1 };
+  static constexpr auto neg_nan() noexcept -> const char* { return "nan"; }
+};
+
+/// The output of Rust's Debug formatting ({:?}): fixed notation for magnitudes
+/// in [1e-4, 1e16) with ".0" after integers, exponents such as "1e16" and
+/// "1e-5", and "NaN". Rust breaks exact ties between two 17-digit candidates
+/// upwards rather than to even so such values may differ in the last digit.
+struct rust_policy : write_policy<-4, 15> {
+  enum { min_exp_digits = 1, exp_plus = 0, point_zero = 1 };
+  static constexpr auto nan() noexcept -> const char* { return "NaN"; }
+  static constexpr auto neg_nan() noexcept -> const char* { return "NaN"; }
+};
+
+/// The output of Go's strconv.FormatFloat(value, 'g', -1, bitSize) and fmt's
+/// %v: fixed notation for magnitudes in [1e-4, 1e6), exponents such as
+/// "1e+06", "+Inf" and "NaN".
+struct go_policy : write_policy<-4, 5> {
+  static constexpr auto inf() noexcept -> const char* { return "+Inf"; }
+  static constexpr auto neg_inf() noexcept -> const char* { return "-Inf"; }
+  static constexpr auto nan() noexcept -> const char* { return "NaN"; }
+  static constexpr auto neg_nan() noexcept -> const char* { return "NaN"; }
+};
+
+/// A policy that writes `DecimalPoint` instead of '.' and, unless
+/// `GroupSeparator` is 0, separates groups of three integer digits in fixed
+/// notation, e.g. "1.234.567,5" for `locale_policy<',', '.'>`. Fixed notation
+/// must fit in 32 characters. `locale_policy<','>`, `locale_policy<',', '.'>`
+/// and `locale_policy<'.', ','>` are instantiated in zmij-policies. The digits
+/// and separators are placed with a shuffle on SSE4.1 and NEON and with a
+/// byte loop elsewhere, including x86-64 without SSE4.1.
+template <char DecimalPoint, char GroupSeparator = 0,
+          typename Base = write_policy<-4, 15>>
+struct locale_policy : Base {
+  enum { decimal_point = DecimalPoint, group_separator = GroupSeparator };
+};
+
+/// Writes the shortest correctly rounded decimal representation of `value` to
+/// `out` like `write` but choosing the notation according to `Policy`, e.g.
+///   zmij::basic_write<zmij::js_notation>(out, n, 1e20)
+/// writes "100000000000000000000". The policies defined here are instantiated
+/// in zmij-policies (zmij-policies.cc), others require ZMIJ_HEADER_ONLY=1.
+template <typename Policy>
+auto basic_write(char* out, size_t n, float value) noexcept -> char* {
+  if (n >= double_buffer_size) return detail::basic_write<Policy>(value, out);
+  char buffer[double_buffer_size];
+  size_t size = detail::basic_write<Policy>(value, buffer) - buffer;
+  if (size > n) size = n;
+  memcpy(out, buffer, size);
+  return out + size;
+}
+
+/// Writes the shortest correctly rounded decimal representation of `value` to
+/// `out` like `write` but choosing the notation according to `Policy`.
+template <typename Policy>
+auto basic_write(char* out, size_t n, double value) noexcept -> char* {
+  if (n >= double_buffer_size) return detail::basic_write<Policy>(value, out);
+  char buffer[double_buffer_size];
+  size_t size = detail::basic_write<Policy>(value, buffer) - buffer;
+  if (size > n) size = n;
+  memcpy(out, buffer, size);
+  return out + size;
+}
+
+/// Writes `value` like `write` aligned in a field of `width` characters with
+/// the rest filled with `fill`, e.g. "   1.5" for width 6. The output is not
+/// truncated if it is wider than the field. The digits are written directly
+/// into their aligned position so `out` must have room for
+/// `width + double_buffer_size` characters. Returns a pointer past the end.
+/// Defined in zmij-policies.
+inline auto write_padded(char* out, size_t width, double value,
+                         char fill = ' ',
+                         align alignment = align::right) noexcept -> char* {
+  return detail::write_padded(value, out, width, fill, alignment);
+}
+
+/// Writes `value` like `write` aligned in a field of `width` characters.
+inline auto write_padded(char* out, size_t width, float value, char fill = ' ',
+                         align alignment = align::right) noexcept -> char* {
+  return detail::write_padded(value, out, width, fill, alignment);
+}
+
+/// Writes `count` values from `values` aligned in consecutive fields of
+/// `width` characters, e.g. a column of a text table. Values wider than the
+/// field are not truncated and shift the following fields. `out` must have
+/// room for the output and `double_buffer_size` extra characters.
+inline auto write_padded(char* out, size_t width, const double* values,
+                         size_t count, char fill = ' ',
+                         align alignment = align::right) noexcept -> char* {
+  for (size_t i = 0; i < count; ++i)
+    out = detail::write_padded(values[i], out, width, fill, alignment);
+  return out;
+}
+
+/// Writes `count` values from `values` aligned in consecutive fields of
+/// `width` characters.
+inline auto write_padded(char* out, size_t width, const float* values,
+                         size_t count, char fill = ' ',
+                         align alignment = align::right) noexcept -> char* {
+  for (size_t i = 0; i < count; ++i)
+    out = detail::write_padded(values[i], out, width, fill, alignment);
+  return out;
+}
+
+/// Writes `value` in hexadecimal floating-point notation like C99's %a, e.g.
+/// "0x1.999999999999ap-4" for 0.1, to `out` without a null terminator. Returns
+/// a pointer past the last character written; if the representation exceeds
+/// `n` characters, only the first `n` are written.
+inline auto write_hex(char* out, size_t n, double value) noexcept -> char* {
+  if (n >= hex_buffer_size) return detail::write_hex(value, out);
+  char buffer[hex_buffer_size];
+  size_t size = detail::write_hex(value, buffer) - buffer;
+  if (size > n) size = n;
+  memcpy(out, buffer, size);
+  return out + size;
+}
+
+/// Writes `value` in hexadecimal floating-point notation like %a, which
+/// promotes float to double, e.g. "0x1.99999ap-4" for 0.1f.
+inline auto write_hex(char* out, size_t n, float value) noexcept -> char* {
+  return write_hex(out, n, double(value));
+}
+
+#if ZMIJ_ENABLE_STATS
+// Numbers of times each conversion path was taken by write. Every write is
+// counted in exactly one of zero, non_finite, fixed and exponential.
+struct conversion_stats {
+  unsigned long long writes;
+  unsigned long long zero;         // positive or negative zero
+  unsigned long long non_finite;   // infinity or NaN
+  unsigned long long irregular;    // powers of 2 with an asymmetric interval
+  unsigned long long subnormal;    // subnormals (normalized separately)
+  unsigned long long fixed;        // fixed notation, e.g. 0.001 or 12.5
+  unsigned long long exponential;  // exponential notation, e.g. 1e+20
+  unsigned long long extra_digit;  // scaled significand has an extra digit
+  unsigned long long last_digit;   // the longer candidate was selected
+  unsigned long long short_float;  // float significand below 1e6 rescaled
+};
+
+/// Returns a snapshot of the conversion statistics of the calling thread.
+auto stats() noexcept -> conversion_stats;
+#endif
+
 }  // namespace zmij
 
+#if ZMIJ_HEADER_ONLY
+#  include "zmij.cc"
+#endif
+
 #endif  // ZMIJ_H_